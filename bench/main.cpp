@@ -0,0 +1,266 @@
+/*
+Benchmark of cvui components and layouts.
+
+Each component is rendered headlessly (into an offscreen context, see
+cvui::offscreen()) at several frame sizes (720p, 1080p and 4K) and several
+amounts of widgets per frame (10 to 10,000). For each combination, the
+time per widget, the time per frame and the amount of allocations per frame
+are reported, one JSON object per line, e.g.
+
+{"component":"button","resolution":"1080p","widgets":1000,"frames":52,"ns_per_widget":4321.0,"ms_per_frame":4.321,"allocs_per_frame":0.0}
+
+Allocations are counted by replacing the global operator new, so they
+include everything allocated through it while a frame is rendered (cvui
+and std containers), but not the buffers OpenCV allocates by itself.
+
+Scenarios whose name ends in "-trace" render the same as the scenario
+without the suffix, but with cvui::trace() keeping the zones of the most
+recent frames. cvui_bench_profiler (built with CVUI_PROFILER) compares
+both, e.g. "nested" and "nested-trace", to measure the cost of tracing.
+
+The "composite" scenario renders its buttons once, into the UI layer (see
+cvui::layer()), and then only blends the layer over the frame every frame,
+so its ms_per_frame is the cost of cvui::composite() for that amount of UI.
+
+Usage: cvui_bench [--filter <component>] [--min-time <seconds>]
+
+Code licensed under the MIT license, check LICENSE file.
+*/
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+#define CVUI_IMPLEMENTATION
+#include "cvui.h"
+
+static std::atomic<unsigned long long> gAllocations(0);
+
+void *operator new(size_t theSize) {
+	gAllocations.fetch_add(1, std::memory_order_relaxed);
+	void *aPtr = std::malloc(theSize == 0 ? 1 : theSize);
+
+	if (aPtr == nullptr) {
+		throw std::bad_alloc();
+	}
+	return aPtr;
+}
+
+void operator delete(void *thePtr) noexcept {
+	std::free(thePtr);
+}
+
+void operator delete(void *thePtr, size_t) noexcept {
+	std::free(thePtr);
+}
+
+// Most sparkline points rendered in a single frame, so the big sparklines
+// are not rendered thousands of times per frame (which would take forever).
+static const double MAX_SPARKLINE_POINTS = 1e7;
+static const int MAX_WIDGETS = 10000;
+
+struct Resolution {
+	const char *name;
+	int width;
+	int height;
+};
+
+struct Scenario {
+	std::string name;
+	int cellWidth;   // space taken by each widget, so widgets are laid out in a grid.
+	int cellHeight;
+	int points;      // points of each sparkline, if the scenario renders sparklines.
+};
+
+static bool gStates[MAX_WIDGETS];
+static double gValues[MAX_WIDGETS];
+static std::vector<double> gSparkline;
+static cv::Mat gImage;
+static std::vector<cvui::cvui_annotation_t> gAnnotations;
+static const char *gClasses[] = { "person 0.91", "car 0.87", "dog 0.64", "bicycle 0.72" };
+static const unsigned int gColors[] = { 0x00ff00, 0xff0000, 0x0000ff, 0xffff00 };
+
+void render(const Scenario& theScenario, cv::Mat& theFrame, int theIndex, int theX, int theY) {
+	const std::string& aName = theScenario.name;
+
+	if (aName == "button" || aName == "button-skin" || aName == "composite") {
+		cvui::button(theFrame, theX, theY, "Button");
+
+	} else if (aName == "checkbox") {
+		cvui::checkbox(theFrame, theX, theY, "Checkbox", &gStates[theIndex]);
+
+	} else if (aName == "trackbar") {
+		// Many segments, so the trackbar renders many ticks.
+		cvui::trackbar(theFrame, theX, theY, 200, &gValues[theIndex], 0.0, 100.0, 100);
+
+	} else if (aName.compare(0, 9, "sparkline") == 0) {
+		cvui::sparkline(theFrame, gSparkline, theX, theY, theScenario.cellWidth - 10, theScenario.cellHeight - 10);
+
+	} else if (aName == "text") {
+		cvui::text(theFrame, theX, theY, "The quick brown fox");
+
+	} else if (aName == "window") {
+		cvui::window(theFrame, theX, theY, theScenario.cellWidth - 10, theScenario.cellHeight - 10, "Window");
+
+	} else if (aName == "rect-alpha") {
+		cvui::rect(theFrame, theX, theY, theScenario.cellWidth - 10, theScenario.cellHeight - 10, 0xff0000, 0x80ff0000);
+
+	} else if (aName == "image") {
+		cvui::image(theFrame, theX, theY, gImage);
+
+	} else if (aName == "nested" || aName == "nested-trace") {
+		cvui::beginRow(theFrame, theX, theY, -1, -1, 5);
+			cvui::beginColumn(-1, -1, 2);
+				cvui::text("Nested");
+				cvui::checkbox("On", &gStates[theIndex]);
+			cvui::endColumn();
+			cvui::beginColumn(-1, -1, 2);
+				cvui::rect(20, 10, 0xff0000, 0xff0000);
+				cvui::text("Done");
+			cvui::endColumn();
+		cvui::endRow();
+	}
+}
+
+int main(int argc, const char *argv[])
+{
+	const Resolution aResolutions[] = { { "720p", 1280, 720 }, { "1080p", 1920, 1080 }, { "4K", 3840, 2160 } };
+	const int aCounts[] = { 10, 100, 1000, 10000 };
+	std::vector<Scenario> aScenarios;
+	const char *aFilter = nullptr;
+	double aMinTime = 0.25;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+			aFilter = argv[++i];
+		} else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+			aMinTime = atof(argv[++i]);
+		} else {
+			fprintf(stderr, "Usage: %s [--filter <component>] [--min-time <seconds>]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	aScenarios.push_back({ "button", 110, 40, 0 });
+	aScenarios.push_back({ "button-skin", 110, 40, 0 });
+	aScenarios.push_back({ "checkbox", 110, 25, 0 });
+	aScenarios.push_back({ "trackbar", 220, 60, 0 });
+	aScenarios.push_back({ "sparkline-1e2", 160, 60, 100 });
+	aScenarios.push_back({ "sparkline-1e4", 160, 60, 10000 });
+	aScenarios.push_back({ "sparkline-1e6", 160, 60, 1000000 });
+	aScenarios.push_back({ "text", 160, 20, 0 });
+	aScenarios.push_back({ "window", 160, 100, 0 });
+	aScenarios.push_back({ "rect-alpha", 100, 50, 0 });
+	aScenarios.push_back({ "image", 40, 40, 0 });
+	aScenarios.push_back({ "nested", 160, 50, 0 });
+	aScenarios.push_back({ "nested-trace", 160, 50, 0 });
+	aScenarios.push_back({ "annotations", 100, 80, 0 });
+	aScenarios.push_back({ "composite", 110, 40, 0 });
+
+	gImage = cv::Mat(32, 32, CV_8UC3, cv::Scalar(0, 128, 255));
+
+	// Headless, i.e. no window and no highgui: everything goes into an offscreen context.
+	cvui::cvui_context_t *aContext = cvui::offscreen("bench");
+	cvui::context(aContext);
+
+	for (const Scenario& aScenario : aScenarios) {
+		if (aFilter != nullptr && aScenario.name.find(aFilter) == std::string::npos) {
+			continue;
+		}
+
+		// Skinned buttons are compared with the default ones, so the skin is only used by its scenario.
+		cv::Mat aSkin(16, 16, CV_8UC4, cv::Scalar(90, 60, 30, 255));
+		cvui::skin(cvui::SKIN_BUTTON, aScenario.name == "button-skin" ? aSkin : cv::Mat(), 4, 4, 4, 4, cvui::OUT);
+
+		// Tracing only records zones if CVUI_PROFILER is defined, otherwise both scenarios cost the same.
+		bool aTraced = aScenario.name.size() > 6 && aScenario.name.compare(aScenario.name.size() - 6, 6, "-trace") == 0;
+		cvui::trace(aTraced ? 120 : 0, aContext);
+
+		gSparkline.resize(aScenario.points);
+		for (int i = 0; i < aScenario.points; i++) {
+			gSparkline[i] = std::sin(i * 0.01) * 100.0;
+		}
+
+		for (const Resolution& aResolution : aResolutions) {
+			cv::Mat aFrame(aResolution.height, aResolution.width, CV_8UC3, cv::Scalar(49, 52, 49));
+			int aColumns = std::max(1, aResolution.width / aScenario.cellWidth);
+			int aRows = std::max(1, aResolution.height / aScenario.cellHeight);
+
+			for (int aCount : aCounts) {
+				if ((double)aScenario.points * aCount > MAX_SPARKLINE_POINTS) {
+					continue;
+				}
+
+				// Annotations are drawn in a single call per frame, like the output of a detector.
+				gAnnotations.resize(aCount);
+				for (int i = 0; i < aCount; i++) {
+					int aCell = i % (aColumns * aRows);
+					gAnnotations[i] = { cv::Rect((aCell % aColumns) * aScenario.cellWidth, (aCell / aColumns) * aScenario.cellHeight + 20, aScenario.cellWidth - 10, aScenario.cellHeight - 30), gClasses[i % 4], gColors[i % 4], 0xc0ff0000 };
+				}
+
+				// The layer is rendered once, so frames only blend it.
+				bool aComposited = aScenario.name == "composite";
+				if (aComposited) {
+					cv::Mat& aLayer = cvui::layer(aFrame.size());
+
+					for (int i = 0; i < aCount; i++) {
+						int aCell = i % (aColumns * aRows);
+						render(aScenario, aLayer, i, (aCell % aColumns) * aScenario.cellWidth, (aCell / aColumns) * aScenario.cellHeight);
+					}
+				}
+
+				auto aFrameOf = [&]() {
+					if (aScenario.name == "annotations") {
+						cvui::annotations(aFrame, gAnnotations.data(), gAnnotations.size());
+					} else if (aComposited) {
+						cvui::composite(aFrame);
+					}
+
+					for (int i = 0; i < aCount && aScenario.name != "annotations" && !aComposited; i++) {
+						// When there are more widgets than cells, widgets are rendered over each other.
+						int aCell = i % (aColumns * aRows);
+						render(aScenario, aFrame, i, (aCell % aColumns) * aScenario.cellWidth, (aCell / aColumns) * aScenario.cellHeight);
+					}
+					cvui::update(aContext);
+				};
+
+				// Warm up, so caches (e.g. the widget store) are already in place.
+				aFrameOf();
+				aFrameOf();
+
+				unsigned long long aAllocations = gAllocations.load();
+				auto aStart = std::chrono::steady_clock::now();
+				double aElapsed = 0;
+				int aFrames = 0;
+
+				while (aFrames < 3 || (aElapsed < aMinTime && aFrames < 1000)) {
+					aFrameOf();
+					aFrames++;
+					aElapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - aStart).count();
+				}
+
+				aAllocations = gAllocations.load() - aAllocations;
+
+				if (aComposited) {
+					cvui::layer(cv::Size());
+				}
+
+				printf("{\"component\":\"%s\",\"resolution\":\"%s\",\"widgets\":%d,\"frames\":%d,\"ns_per_widget\":%.1f,\"ms_per_frame\":%.3f,\"allocs_per_frame\":%.1f}\n",
+					aScenario.name.c_str(), aResolution.name, aCount, aFrames, aElapsed * 1e9 / ((double)aFrames * aCount), aElapsed * 1e3 / aFrames, (double)aAllocations / aFrames);
+				fflush(stdout);
+			}
+		}
+	}
+
+	return 0;
+}
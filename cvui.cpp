@@ -0,0 +1,16 @@
+/*
+ Implementation of cvui, compiled into the cvui library (see the CMake target cvui).
+
+ Applications linking the library only include cvui.h, without defining
+ CVUI_IMPLEMENTATION, so the implementation is compiled a single time.
+ The CMake target informs CVUI_PRECOMPILED to everyone linking it, which
+ makes cvui.h ignore CVUI_IMPLEMENTATION in code written for the
+ single-header mode.
+
+ Copyright (c) 2016 Fernando Bevilacqua <dovyski@gmail.com>
+ Licensed under the MIT license.
+*/
+
+#define CVUI_IMPLEMENTATION
+#define CVUI_DISABLE_COMPILATION_NOTICES
+#include "cvui.h"
@@ -58,19 +58,86 @@
 #ifndef _CVUI_H_
 #define _CVUI_H_
 
+// Only what the declarations below need is included here. Headers used by the
+// implementation alone are included with it, so files using cvui (with its
+// implementation compiled elsewhere) build faster.
 #include <iostream>
 #include <vector>
-#include <map>
-#include <stdarg.h>
+#include <string>
+#include <atomic>
+#include <stdexcept>
+#include <stdint.h>
+#include <stdio.h>
 
 #include <opencv2/imgproc/imgproc.hpp>
-#include <opencv2/highgui/highgui.hpp>
 #include <opencv2/core/core.hpp>
 
+// If CVUI_HEADLESS is defined, cvui does not use highgui at all, so it can be linked
+// without opencv_highgui, e.g. to render UI overlays on servers without a display.
+// No window is created or shown, and input must be informed programmatically.
+#ifndef CVUI_HEADLESS
+#include <opencv2/highgui/highgui.hpp>
+#endif
+
 namespace cvui
 {
+// Set by cvui::theme(), which must not be called while other threads render components.
 extern double DEFAULT_FONT_SCALE;
 extern unsigned int DEFAULT_BUTTON_COLOR;
+extern unsigned int DEFAULT_TEXT_COLOR;
+
+// Describes the state of a table component. Defined below.
+struct cvui_table_t;
+
+// Describes the state of a widget that is kept across frames. Defined below.
+struct cvui_widget_t;
+
+// Describes a sample of the mouse motion. Defined below.
+struct cvui_mouse_sample_t;
+
+// Describes a key pressed in a window. Defined below.
+struct cvui_key_event_t;
+
+// Describes the performance statistics of a frame. Defined below.
+struct cvui_profile_t;
+
+// Describes the colors and metrics used to render components. Defined below.
+struct cvui_theme_t;
+
+// Describes a (window) context. Defined below. Pointers to contexts are used
+// as handles, so windows can be referred to without looking up their names.
+struct cvui_context_t;
+
+// Function used by the table component to format the content of a cell.
+// It receives the row and column of the cell and must write a null-terminated
+// string into theBuffer, which can hold up to theBufferSize bytes.
+typedef void (*cvui_table_cell_t)(int theRow, int theColumn, char *theBuffer, size_t theBufferSize, void *theData);
+
+// Describes an annotation, e.g. an object found by a detector, see cvui::annotations().
+typedef struct {
+	cv::Rect box;                // area of the annotation.
+	const char *label;           // text shown on top of the box, e.g. "person 0.93", or nullptr for no text.
+	unsigned int color;          // color of the border and of the label background in the format 0xRRGGBB.
+	unsigned int fillingColor;   // color of the filling in the format 0xAARRGGBB, e.g. 0xff000000 for no filling.
+} cvui_annotation_t;
+
+// Function called whenever cvui allocates memory from the heap, see cvui::allocationHook().
+// It receives the place where the allocation happened (e.g. "widgets") and its size in bytes,
+// or zero if the size is not known.
+typedef void (*cvui_allocation_hook_t)(const char *theSite, size_t theSize, void *theData);
+
+// Function called when cvui finds an error and the policy is cvui::ERROR_CALLBACK, see cvui::errorPolicy().
+// It receives the code of the error (e.g. 1 for a mismatch in begin*()/end*() calls) and its description.
+typedef void (*cvui_error_callback_t)(int theCode, const char *theMessage, void *theData);
+
+// Exception thrown when cvui finds an error and the policy is cvui::ERROR_EXCEPTION, see cvui::errorPolicy().
+class cvui_exception_t : public std::runtime_error {
+public:
+	int code; // code of the error, e.g. 1 for a mismatch in begin*()/end*() calls.
+
+	inline cvui_exception_t(int theCode, const char *theMessage) : std::runtime_error(theMessage), code(theCode) {}
+};
+
 /**
  Initializes cvui. You must provide the name of the window where
  components will be added. It is also possible to tell cvui to handle
@@ -84,10 +151,12 @@ extern unsigned int DEFAULT_BUTTON_COLOR;
  \param theDelayWaitKey delay value passed to `cv::waitKey()`. If a negative value is informed (default is `-1`), cvui will not automatically call `cv::waitKey()` within `cvui::update()`, which will disable keyboard shortcuts for all components. If you want to enable keyboard shortcut for components (e.g. using & in a button label), you must specify a positive value for this param.
  \param theCreateNamedWindow if an OpenCV window named `theWindowName` should be created during the initialization. Windows are created using `cv::namedWindow()`. If this parameter is `false`, ensure you call `cv::namedWindow(WINDOW_NAME)` *before* initializing cvui, otherwise it will not be able to track UI interactions. 
 
+ \return a handle to the context of the window, which can be used instead of the window name in functions like `cvui::context()` and `cvui::update()`.
+
  \sa watch()
  \sa context()
 */
-void init(const cv::String& theWindowName, int theDelayWaitKey = -1, bool theCreateNamedWindow = true);
+cvui_context_t *init(const cv::String& theWindowName, int theDelayWaitKey = -1, bool theCreateNamedWindow = true);
 
 /**
  Initialize cvui using a list of names of windows where components will be added.
@@ -102,10 +171,12 @@ void init(const cv::String& theWindowName, int theDelayWaitKey = -1, bool theCre
  \param theDelayWaitKey delay value passed to `cv::waitKey()`. If a negative value is informed (default is `-1`), cvui will not automatically call `cv::waitKey()` within `cvui::update()`, which will disable keyboard shortcuts for all components. If you want to enable keyboard shortcut for components (e.g. using & in a button label), you must specify a positive value for this param.
  \param theCreateNamedWindows if OpenCV windows named according to `theWindowNames` should be created during the initialization. Windows are created using `cv::namedWindow()`. If this parameter is `false`, ensure you call `cv::namedWindow(WINDOW_NAME)` for all windows *before* initializing cvui, otherwise it will not be able to track UI interactions.
 
+ \return a handle to the context of the first window in `theWindowNames`. Use `cvui::watch()` to get the handles of the other windows.
+
  \sa watch()
  \sa context()
 */
-void init(const cv::String theWindowNames[], size_t theHowManyWindows, int theDelayWaitKey = -1, bool theCreateNamedWindows = true);
+cvui_context_t *init(const cv::String theWindowNames[], size_t theHowManyWindows, int theDelayWaitKey = -1, bool theCreateNamedWindows = true);
 
 /**
  Track UI interactions of a particular window. This function must be invoked
@@ -118,10 +189,29 @@ void init(const cv::String theWindowNames[], size_t theHowManyWindows, int theDe
  \param theWindowName name of the window whose UI interactions will be tracked.
  \param theCreateNamedWindow if an OpenCV window named `theWindowName` should be created before it is watched. Windows are created using `cv::namedWindow()`. If this parameter is `false`, ensure you have called `cv::namedWindow(WINDOW_NAME)` to create the window, otherwise cvui will not be able to track its UI interactions.
 
+ \return a handle to the context of the window, which can be used instead of the window name in functions like `cvui::context()` and `cvui::update()`. Handles remain valid for as long as cvui is in use, even if the window is watched again.
+
  \sa init()
  \sa context()
 */
-void watch(const cv::String& theWindowName, bool theCreateNamedWindow = true);
+cvui_context_t *watch(const cv::String& theWindowName, bool theCreateNamedWindow = true);
+
+/**
+ Create a context that is not attached to any window, e.g. to render components into a `cv::Mat`
+ that will never be shown, like the frames of a video stream on a server. The context works as
+ any other one, i.e. use `cvui::context()` and `cvui::update()` with it. Since there is no window,
+ input must be informed programmatically, e.g. using `cvui::injectMouse()` and `cvui::injectKey()`. `cvui::imshow()` only updates offscreen contexts, nothing is shown.
+
+ Offscreen contexts can be used without `cvui::init()` and in builds where `CVUI_HEADLESS` is defined,
+ which do not depend on highgui at all.
+
+ \param theName name of the context. It must not be the name of a window in use by cvui.
+ \return a handle to the context.
+
+ \sa context()
+ \sa update()
+*/
+cvui_context_t *offscreen(const cv::String& theName);
 
 /**
  Inform cvui that all subsequent component calls belong to a window in particular.
@@ -184,6 +274,19 @@ void watch(const cv::String& theWindowName, bool theCreateNamedWindow = true);
 */
 void context(const cv::String& theWindowName);
 
+/**
+ Inform cvui that all subsequent component calls belong to a window in particular.
+ This function behaves exactly like `cvui::context(const cv::String&)`, however the
+ window is informed by its handle, i.e. the value returned by `cvui::init()` or `cvui::watch()`,
+ so no lookup by name is performed.
+
+ \param theContext handle of the window that will receive components from all subsequent cvui calls.
+
+ \sa init()
+ \sa watch()
+*/
+void context(cvui_context_t *theContext);
+
 /**
  Display an image in the specified window and update the internal structures of cvui.
  This function can be used as a replacement for `cv::imshow()`. If you want to use
@@ -196,22 +299,66 @@ void context(const cv::String& theWindowName);
 
  \param theWindowName name of the window that will be shown.
  \param theFrame image, i.e. `cv::Mat`, to be shown in the window.
+ \return `true` if the window needs to be redrawn, as returned by `cvui::update()`.
+
+ \sa update()
+ \sa context()
+ \sa watch()
+*/
+bool imshow(const cv::String& theWindowName, cv::InputArray theFrame);
+
+/**
+ Display an image in the specified window and update the internal structures of cvui.
+ This function behaves exactly like `cvui::imshow(const cv::String&, cv::InputArray)`,
+ however the window is informed by its handle, i.e. the value returned by `cvui::init()` or `cvui::watch()`.
+
+ \param theContext handle of the window that will be shown.
+ \param theFrame image, i.e. `cv::Mat`, to be shown in the window.
+ \return `true` if the window needs to be redrawn, as returned by `cvui::update()`.
 
  \sa update()
  \sa context()
  \sa watch()
 */
-void imshow(const cv::String& theWindowName, cv::InputArray theFrame);
+bool imshow(cvui_context_t *theContext, cv::InputArray theFrame);
 
 /**
- Return the last key that was pressed. This function will only
- work if a value greater than zero was passed to `cvui::init()`
- as the delay waitkey parameter.
+ Return the last key that was pressed in the current frame of the current window,
+ or `-1` if no key was pressed. The key is the one `cv::waitKey()` returns, e.g. `'q'`
+ or `27` (ESC), see `cvui_key_event_t::key`. This function will only work if a value greater
+ than zero was passed to `cvui::init()` as the delay waitkey parameter.
 
  \sa init()
+ \sa keys()
 */
 int lastKeyPressed();
 
+/**
+ Return all keys pressed in a window that belong to the current frame, in the order
+ they were pressed. Keys are queued per window, so keys typed while the application
+ is busy are not lost: they are handed out in the following frames, one press of each
+ key per frame. Since OpenCV does not tell which window a key was pressed in, the key
+ goes to the window that received the most recent mouse activity or, if no window
+ received any, to the window that was being updated.
+
+ Components with keyboard shortcuts (e.g. `cvui::button()` with a label like "&Quit")
+ mark the keys they used as consumed, so each key press activates a single shortcut.
+
+ Each key has the value `cv::waitKey()` returns (`key`, e.g. `'q'`), the full code returned
+ by `cv::waitKeyEx()` (`code`, which tells special keys like arrows apart) and the modifier
+ keys held down (`modifiers`, e.g. `cvui::KEY_CTRL`). OpenCV only reports modifiers on GTK,
+ so `modifiers` is always `0` with other backends.
+
+ Keys are collected by the `cv::waitKey()` call cvui performs, i.e. this function will only
+ work if a value greater than zero was passed to `cvui::init()` as the delay waitkey parameter.
+
+ \param theWindowName name of the window whose keys will be returned. If nothing is informed (default), the current context (or the default window) is used.
+ \return list of keys pressed in the window in the current frame.
+
+ \sa lastKeyPressed()
+*/
+const std::vector<cvui_key_event_t>& keys(const cv::String& theWindowName = "");
+
 /**
  Return the last position of the mouse.
 
@@ -287,6 +434,103 @@ bool mouse(int theButton, int theQuery);
 */
 bool mouse(const cv::String& theWindowName, int theButton, int theQuery);
 
+/**
+ Return all positions the mouse cursor went through since the last frame, in the order
+ they happened. OpenCV usually reports mouse motion much more often than an application
+ renders frames, so those samples can be used to reconstruct smooth paths (e.g. when drawing
+ strokes) even if the frame rate is low. The last sample matches `cvui::mouse()`.
+
+ The samples refer to the current frame only, i.e. they are replaced in the frame after
+ `cvui::update()` is called for the window. If the mouse did not move since the last frame,
+ the returned list is empty. Otherwise, the first sample is the last position of the previous
+ frame with motion (flagged as `carried`), so paths drawn from consecutive samples continue
+ across frames without gaps.
+
+ ```
+ const std::vector<cvui::cvui_mouse_sample_t>& samples = cvui::mouseSamples();
+ for (size_t i = 1; i < samples.size(); i++) {
+   if (samples[i].pressed) {
+     cv::line(canvas, samples[i - 1].position, samples[i].position, cv::Scalar(0, 255, 0));
+   }
+ }
+ ```
+
+ \param theWindowName name of the window whose mouse cursor will be used. If nothing is informed (default), the current context (or the default window) is used.
+ \return list of samples of the mouse motion since the last frame.
+
+ \sa mouse(const cv::String&)
+*/
+const std::vector<cvui_mouse_sample_t>& mouseSamples(const cv::String& theWindowName = "");
+
+/**
+ Give an explicit id to the next component. cvui is positional, so by default components
+ are identified by a hash of their label (if any) and their position. If a component moves
+ or shares a label and position with another component, you can use this function to give it
+ an id that is stable across frames, e.g.
+
+ ```
+ cvui::id("save");
+ cvui::button(frame, x, y, "Save");
+ cvui::widget(cvui::lastId()).value = 10; // state of the "save" button
+ ```
+
+ Ids are scoped by the ids pushed with `cvui::pushId()`, so the same name can be
+ used in different scopes without clashing.
+
+ \param theId name that will be hashed into the id of the next component.
+ \return the id that the next component will have.
+
+ \sa pushId()
+ \sa lastId()
+ \sa widget()
+*/
+unsigned int id(const cv::String& theId);
+
+/**
+ Start a scope for component ids. All components (and explicit ids) created until
+ the matching `cvui::popId()` will have ids derived from `theId`. This is useful to
+ create several instances of the same piece of UI, e.g. one per item of a list,
+ without their components clashing. Every `pushId()` must have a matching `popId()`
+ before `cvui::update()` is called.
+
+ \param theId name of the scope.
+
+ \sa popId()
+ \sa id()
+*/
+void pushId(const cv::String& theId);
+
+/**
+ End a scope for component ids started by `cvui::pushId()`.
+
+ \sa pushId()
+*/
+void popId();
+
+/**
+ Return the id of the last component that was rendered in the current context.
+
+ \return id of the last component.
+
+ \sa id()
+ \sa widget()
+*/
+unsigned int lastId();
+
+/**
+ Return the state cvui keeps for a component across frames. The state is stored in
+ the current context (window) and it is created the first time it is requested. States
+ of components that are not requested for a while are discarded. The returned reference
+ is valid until the next call to `cvui::widget()`.
+
+ \param theId id of the component, e.g. the value returned by `cvui::lastId()` or `cvui::id()`.
+ \return a reference to the state of the component.
+
+ \sa id()
+ \sa lastId()
+*/
+cvui_widget_t& widget(unsigned int theId);
+
 /**
  Display a button. The size of the button will be automatically adjusted to
  properly house the label content.
@@ -337,12 +581,16 @@ bool button(cv::Mat& theWhere, int theX, int theY, int theWidth, int theHeight,
 bool button(cv::Mat& theWhere, int theX, int theY, cv::Mat& theIdle, cv::Mat& theOver, cv::Mat& theDown);
 
 /**
- Display an image (cv::Mat). 
+ Display an image (cv::Mat). If the image and the frame have different types,
+ e.g. a `CV_8UC3` image on a `CV_8UC1` or `CV_16UC1` frame, the image is
+ converted while it is copied. Images without alpha rendered on 4-channel frames
+ are opaque, i.e. their alpha channel becomes `255` (`65535` on `CV_16UC4` frames),
+ like everything else cvui renders on such frames.
 
  \param theWhere image/frame where the provded image should be rendered.
  \param theX position X where the image should be placed.
  \param theY position Y where the image should be placed.
- \param theImage image to be rendered in the specified destination.
+ \param theImage image to be rendered in the specified destination. It must have 1, 3 or 4 channels.
 
  \sa button()
  \sa iarea()
@@ -358,10 +606,10 @@ void image(cv::Mat& theWhere, int theX, int theY, cv::Mat& theImage);
  \param theY position Y where the component should be placed.
  \param theLabel text displayed besides the clickable checkbox square.
  \param theState describes the current state of the checkbox: `true` means the checkbox is checked.
- \param theColor color of the label in the format `0xRRGGBB`, e.g. `0xff0000` for red.
+ \param theColor color of the label in the format `0xRRGGBB`, e.g. `0xff0000` for red. The default is the text color of the theme, see `cvui::theme()`.
  \return a boolean value that indicates the current state of the checkbox, `true` if it is checked.
 */
-bool checkbox(cv::Mat& theWhere, int theX, int theY, const cv::String& theLabel, bool *theState, unsigned int theColor = 0xCECECE, double theFontScale = DEFAULT_FONT_SCALE);
+bool checkbox(cv::Mat& theWhere, int theX, int theY, const cv::String& theLabel, bool *theState, unsigned int theColor = DEFAULT_TEXT_COLOR, double theFontScale = DEFAULT_FONT_SCALE);
 
 /**
  Display a piece of text.
@@ -371,11 +619,11 @@ bool checkbox(cv::Mat& theWhere, int theX, int theY, const cv::String& theLabel,
  \param theY position Y where the component should be placed.
  \param theText the text content.
  \param theFontScale size of the text.
- \param theColor color of the text in the format `0xRRGGBB`, e.g. `0xff0000` for red.
+ \param theColor color of the text in the format `0xRRGGBB`, e.g. `0xff0000` for red. The default is the text color of the theme, see `cvui::theme()`.
 
  \sa printf()
 */
-void text(cv::Mat& theWhere, int theX, int theY, const cv::String& theText, double theFontScale = DEFAULT_FONT_SCALE, unsigned int theColor = 0xCECECE);
+void text(cv::Mat& theWhere, int theX, int theY, const cv::String& theText, double theFontScale = DEFAULT_FONT_SCALE, unsigned int theColor = DEFAULT_TEXT_COLOR);
 
 /**
  Display a piece of text that can be formated using `stdio's printf()` style. For instance
@@ -530,6 +778,155 @@ void rect(cv::Mat& theWhere, int theX, int theY, int theWidth, int theHeight, un
 */
 void sparkline(cv::Mat& theWhere, std::vector<double>& theValues, int theX, int theY, int theWidth, int theHeight, unsigned int theColor = 0x00FF00);
 
+/**
+ Display a table with a fixed header, scrollable rows and row selection. The content of the
+ table is not stored by cvui. Instead, the table asks `theCell` to format the content of
+ each cell, e.g.
+
+ ```
+ void cell(int theRow, int theColumn, char *theBuffer, size_t theBufferSize, void *theData) {
+   snprintf(theBuffer, theBufferSize, "%d", values[theRow][theColumn]);
+ }
+
+ cvui::cvui_table_t table;
+ const cv::String headers[] = { "Id", "Score" };
+ const int widths[] = { 60, 80 };
+ cvui::table(frame, 10, 10, 160, 200, &table, rowCount, 2, headers, widths, cell);
+ ```
+
+ Only the rows that are visible are formatted and rendered, so the amount of rows can be
+ very large. The formatted text of visible cells is cached in `theTable`, so `theCell`
+ is only called for rows that became visible since the last frame. If the content of rows that
+ are already visible changes, call `tableInvalidate()` so they are formatted again.
+
+ The table can be scrolled with the mouse wheel or by dragging its scrollbar. Clicking
+ a row selects it.
+
+ \param theWhere image/frame where the component should be rendered.
+ \param theX position X where the component should be placed.
+ \param theY position Y where the component should be placed.
+ \param theWidth width of the table.
+ \param theHeight height of the table, including the header.
+ \param theTable state of the table (scroll position, selected row and cached cells). It must be kept by the caller between frames, one for each table.
+ \param theRows number of rows in the table.
+ \param theColumns number of columns in the table.
+ \param theHeaders array with `theColumns` titles used in the header. If `nullptr` is informed, the table is rendered without a header.
+ \param theColumnWidths array with the width, in pixels, of each one of the `theColumns` columns.
+ \param theCell function used to format the content of a cell.
+ \param theData pointer passed to `theCell` as is, e.g. the data being displayed.
+ \param theFontScale size of the text.
+ \return index of the selected row, or `-1` if no row is selected.
+
+ \sa tableInvalidate()
+*/
+int table(cv::Mat& theWhere, int theX, int theY, int theWidth, int theHeight, cvui_table_t *theTable, int theRows, int theColumns, const cv::String theHeaders[], const int theColumnWidths[], cvui_table_cell_t theCell, void *theData = nullptr, double theFontScale = DEFAULT_FONT_SCALE);
+
+/**
+ Discard the formatted text that a table has cached for its rows, so they will be
+ formatted again (by calling the table's cell function) the next time they are visible.
+ Call this function when the content of a row that is currently visible changes.
+
+ \param theTable state of the table whose cache will be discarded.
+ \param theRow index of the row whose cache will be discarded. If a negative value is informed (default), the cache of all rows is discarded.
+
+ \sa table()
+*/
+void tableInvalidate(cvui_table_t *theTable, int theRow = -1);
+
+/**
+ Display many annotations at once, e.g. the bounding boxes found by an object detector, each
+ one with a label like `"person 0.93"`. Each annotation is drawn as a `rect()` (same colors,
+ same filling), plus its label on a tag of the color of the border, placed above the box (or
+ inside it, if there is no room above). It is much faster than calling `rect()` and `text()`
+ for each annotation:
+
+ - borders are drawn without anti-aliasing, i.e. axis-aligned lines written directly into
+   the rows of the frame (`CV_8UC1`, `CV_8UC3` or `CV_8UC4` frames; other types are drawn
+   using `rect()`);
+ - each label is rendered once and kept in a cache of the window, so a label repeated
+   in many boxes or in many frames is only copied. Labels that change every frame, e.g.
+   scores with many decimal places, miss the cache, so keep them short;
+ - rows of the frame are split among all cores (`cv::parallel_for_`). The result is the same
+   as drawing the annotations one after the other, in order.
+
+ Annotations are not components: they don't react to the mouse and don't change the layout.
+
+ \param theWhere image/frame where the annotations should be rendered.
+ \param theAnnotations array with `theCount` annotations, drawn in order (the last one on top).
+ \param theCount amount of annotations in `theAnnotations`.
+ \param theFontScale size of the labels.
+
+ \sa rect()
+*/
+void annotations(cv::Mat& theWhere, const cvui_annotation_t *theAnnotations, size_t theCount, double theFontScale = DEFAULT_FONT_SCALE);
+
+/**
+ Display many annotations at once, e.g. the bounding boxes found by an object detector. Boxes,
+ labels and colors are informed in separate arrays, e.g. the output of `cv::dnn::NMSBoxes()`.
+ See `annotations(cv::Mat&, const cvui_annotation_t*, size_t, double)` for details.
+
+ \param theWhere image/frame where the annotations should be rendered.
+ \param theBoxes area of each annotation.
+ \param theLabels text of each annotation. It can be empty (no labels) or have one text per box.
+ \param theColors color of each annotation in the format `0xRRGGBB`. It can have a single color (used by all boxes) or one color per box.
+ \param theFillingColor color of the filling of all boxes in the format `0xAARRGGBB`, e.g. `0xff000000` for no filling.
+ \param theFontScale size of the labels.
+
+ \sa rect()
+*/
+void annotations(cv::Mat& theWhere, const std::vector<cv::Rect>& theBoxes, const std::vector<cv::String>& theLabels, const std::vector<unsigned int>& theColors, unsigned int theFillingColor = 0xff000000, double theFontScale = DEFAULT_FONT_SCALE);
+
+/**
+ Use an image as the skin of a component, instead of its default look. The image is sliced
+ into nine parts (corners, edges and center) by the informed borders. When the component is
+ rendered, corners keep their size, edges are stretched along their length and the center is
+ stretched in both directions, so a single image fits components of any size, e.g.
+
+ ```
+ cv::Mat image = cv::imread("button.png", cv::IMREAD_UNCHANGED);
+ cvui::skin(cvui::SKIN_BUTTON, image, 6, 6, 6, 6, cvui::OUT);
+ ```
+
+ Stretched skins are cached for each size they are rendered at, so skinned components cost
+ about the same as the default look: a copy (or an alpha blending, for skins with transparency)
+ of the cached image. There is no limit on the amount of sizes, and sizes not rendered for a
+ few hundred frames are dropped from the cache. Skins are shared by all windows and should be set before components are
+ rendered, e.g. right after `cvui::init()`.
+
+ \param theSkin what is skinned: `cvui::SKIN_BUTTON`, `cvui::SKIN_WINDOW_TITLE` (title bar of windows), `cvui::SKIN_WINDOW` (body of windows), `cvui::SKIN_TRACKBAR` (path of trackbars) or `cvui::SKIN_TRACKBAR_HANDLE`.
+ \param theImage `CV_8UC1`, `CV_8UC3` or `CV_8UC4` image used as skin. The alpha channel of `CV_8UC4` images is used for blending (`255` is opaque). If an empty image is informed, the skin is removed.
+ \param theLeft width of the left border of the image, which is not stretched horizontally.
+ \param theTop height of the top border of the image, which is not stretched vertically.
+ \param theRight width of the right border of the image, which is not stretched horizontally.
+ \param theBottom height of the bottom border of the image, which is not stretched vertically.
+ \param theState state of the component that uses this skin: `cvui::OUT`, `cvui::OVER` or `cvui::DOWN`. States without a skin of their own use the skin of `cvui::OUT`, so informing `cvui::OUT` alone is enough.
+*/
+void skin(int theSkin, const cv::Mat& theImage, int theLeft, int theTop, int theRight, int theBottom, int theState);
+
+/**
+ Change the look of all components, e.g.
+
+ ```
+ static cvui::cvui_theme_t light; // starts with the default look of cvui.
+ light.colors[cvui::THEME_WINDOW] = 0xE0E0E0;
+ light.colors[cvui::THEME_TEXT] = 0x202020;
+ cvui::theme(&light);
+ ```
+
+ Everything derived from the colors of the theme (e.g. `cv::Scalar`s and the 3D outline of
+ buttons) is computed once, by `cvui_theme_t::prepare()`, so components do no color math while
+ they are rendered. This function prepares the theme if its colors changed since it was last
+ prepared, so switching among themes that did not change costs the same as setting a pointer.
+ The theme is shared by all windows. It also sets `cvui::DEFAULT_FONT_SCALE`,
+ `cvui::DEFAULT_BUTTON_COLOR` and `cvui::DEFAULT_TEXT_COLOR`, which are plain variables, so
+ this function must not be called while other threads render components.
+
+ \param theTheme theme used from now on. It must exist while it is in use and must not be changed while it is in use (change another theme, then set it instead). If `nullptr` is informed, the default theme is used.
+
+ \sa cvui_theme_t
+*/
+void theme(cvui_theme_t *theTheme);
+
 /**
  Create an interaction area that reports activity with the mouse cursor.
  The tracked interactions are returned by the function and they are:
@@ -765,7 +1162,7 @@ void space(int theValue = 5);
  \sa endRow()
  \sa endColumn()
 */
-void text(const cv::String& theText, double theFontScale = DEFAULT_FONT_SCALE, unsigned int theColor = 0xCECECE);
+void text(const cv::String& theText, double theFontScale = DEFAULT_FONT_SCALE, unsigned int theColor = DEFAULT_TEXT_COLOR);
 
 /**
  Display a button within a `begin*()` and `end*()` block.
@@ -863,7 +1260,7 @@ void image(cv::Mat& theImage);
  \sa endRow()
  \sa endColumn()
 */
-bool checkbox(const cv::String& theLabel, bool *theState, unsigned int theColor = 0xCECECE, double theFontScale = DEFAULT_FONT_SCALE);
+bool checkbox(const cv::String& theLabel, bool *theState, unsigned int theColor = DEFAULT_TEXT_COLOR, double theFontScale = DEFAULT_FONT_SCALE);
 
 /**
  Display a piece of text within a `begin*()` and `end*()` block.
@@ -1050,109 +1447,634 @@ void rect(int theWidth, int theHeight, unsigned int theBorderColor, unsigned int
 */
 void sparkline(std::vector<double>& theValues, int theWidth, int theHeight, unsigned int theColor = 0x00FF00);
 
+/**
+ Display a table with a fixed header, scrollable rows and row selection within a `begin*()` and `end*()` block.
+
+ IMPORTANT: this function can only be used within a `begin*()/end*()` block, otherwise it does nothing.
+
+ \param theWidth width of the table.
+ \param theHeight height of the table, including the header.
+ \param theTable state of the table (scroll position, selected row and cached cells). It must be kept by the caller between frames, one for each table.
+ \param theRows number of rows in the table.
+ \param theColumns number of columns in the table.
+ \param theHeaders array with `theColumns` titles used in the header. If `nullptr` is informed, the table is rendered without a header.
+ \param theColumnWidths array with the width, in pixels, of each one of the `theColumns` columns.
+ \param theCell function used to format the content of a cell.
+ \param theData pointer passed to `theCell` as is, e.g. the data being displayed.
+ \param theFontScale size of the text.
+ \return index of the selected row, or `-1` if no row is selected.
+
+ \sa tableInvalidate()
+ \sa beginColumn()
+ \sa beginRow()
+ \sa endRow()
+ \sa endColumn()
+*/
+int table(int theWidth, int theHeight, cvui_table_t *theTable, int theRows, int theColumns, const cv::String theHeaders[], const int theColumnWidths[], cvui_table_cell_t theCell, void *theData = nullptr, double theFontScale = DEFAULT_FONT_SCALE);
+
 /**
  Update the library internal things. You need to call this function **AFTER** you are done adding/manipulating
  UI elements in order for them to react to mouse interactions.
 
+ The returned value tells if the window needs to be redrawn, i.e. its components used input in this frame
+ (e.g. a button was clicked), there is input waiting for the next frame or `cvui::invalidate()` was called.
+ If it is `false`, nothing would change in the next frame, so the application can block in `cvui::wait()`
+ instead of rendering the same frame again.
+
  \param theWindowName name of the window whose components are being updated. If no window name is provided, cvui uses the default window.
+ \return `true` if the window needs to be redrawn, `false` otherwise.
 
  \sa init()
  \sa watch()
  \sa context()
+ \sa wait()
 */
-void update(const cv::String& theWindowName = "");
-
-// Internally used to handle mouse events
-void handleMouse(int theEvent, int theX, int theY, int theFlags, void* theData);
+bool update(const cv::String& theWindowName = "");
 
-// Compatibility macros to allow compilation with either OpenCV 2.x or OpenCV 3.x
-#if (CV_MAJOR_VERSION < 3)
-	#define CVUI_ANTIALISED CV_AA
-#else
-	#define CVUI_ANTIALISED cv::LINE_AA
-#endif
-#define CVUI_FILLED -1
+/**
+ Update the library internal things. This function behaves exactly like `cvui::update(const cv::String&)`,
+ however the window is informed by its handle, i.e. the value returned by `cvui::init()` or `cvui::watch()`.
 
-// If we are not in a Windows-based environment, replace Windows-specific functions with
-// their POSIX equivalents.
-#if !defined(_MSC_VER)
-	#define vsprintf_s vsprintf
-	#define sprintf_s sprintf
-#endif
+ \param theContext handle of the window whose components are being updated.
+ \return `true` if the window needs to be redrawn, `false` otherwise.
 
-// Adjust things accoridng to platform
-#ifdef _MSC_VER
-	#define _CVUI_COMPILE_MESSAGE(x) message(x)
+ \sa init()
+ \sa watch()
+ \sa context()
+*/
+bool update(cvui_context_t *theContext);
 
-	// If windows.h has already been included, min() and max() will be defined.
-	// In such case, a shit storm will rain on us, producing all kinds of
-	// compilation problems with cvui. If min/max are already defined,
-	// let's undef them for now and redef them at the end of this file.
-	#ifdef min
-		#define __cvui_min min
-		#undef min
-	#endif
-	#ifdef max
-		#define __cvui_max max
-		#undef max
-	#endif
-#elif __GNUC__
-	#define _CVUI_COMPILE_MESSAGE(x) message x
-#endif
+/**
+ Service the events of all windows at once, i.e. call `cv::waitKey()` a single time per frame
+ no matter how many windows are being used, then prepare the input of every window for the
+ next frame. Use it at the end of the frame, after the `cvui::update()`/`cvui::imshow()` calls
+ of all windows:
 
-// Some compilation messages
-#define _CVUI_IMPLEMENTATION_NOTICE "cvui.h: compiling implementation because of CVUI_IMPLEMENTATION. See: https://dovyski.github.io/cvui/usage/"
-#define _CVUI_NO_IMPLEMENTATION_NOTICE "cvui.h: implementation skipped. Ensure one of your C++ files included cvui.h after a #define CVUI_IMPLEMENTATION. See: https://dovyski.github.io/cvui/usage/"
+ ```
+ while (true) {
+   cvui::context(window1); ... cvui::imshow(window1, frame1);
+   cvui::context(window2); ... cvui::imshow(window2, frame2);
 
-// Below is paranoic, dramatic bug-fixing action to ensure no evil macro
-// have already defined our names. For some bizarre reason, cvui did not
-// compile in one of my projects because OUT was already defined. So be it.
-#undef VERSION
-#undef ROW
-#undef COLUMN
-#undef DOWN
-#undef CLICK
-#undef OVER
-#undef OUT
-#undef UP
-#undef IS_DOWN
-#undef LEFT_BUTTON
-#undef MIDDLE_BUTTON
-#undef RIGHT_BUTTON
+   if (cvui::pump(20) == 27) {
+     break; // ESC was pressed.
+   }
+ }
+ ```
 
-// Check for Unix stuff
-#ifdef __GNUC__
-	// just to remove the warning under gcc that is introduced by the VERSION variable below
-	// (needed for those who compile with -Werror (make warning as errors)
-	#pragma GCC diagnostic ignored "-Wunused-variable"
-#endif
+ After a call to `cvui::pump()`, the next `cvui::update()` of each window does not call
+ `cv::waitKey()` again, so the frame latency does not grow with the number of windows. Each
+ window still prepares its own input in `cvui::update()`, in the thread that renders it. If
+ `cvui::pump()` stops being called, `cvui::update()` goes back to calling `cv::waitKey()`.
 
-// Lib version
-static const char *VERSION = "2.7.0";
+ \param theDelayWaitKey delay value passed to `cv::waitKey()`. If a negative value is informed (default), the delay informed in `cvui::init()` is used, or `1` if none was informed.
+ \return the key pressed, as returned by `cv::waitKey()` (e.g. `27` for ESC), or `-1` if no key was pressed. Use `cvui::keys()` for the full codes of special keys.
 
-const int ROW = 0;
-const int COLUMN = 1;
-const int DOWN = 2;
-const int CLICK = 3;
-const int OVER = 4;
-const int OUT = 5;
-const int UP = 6;
-const int IS_DOWN = 7;
+ \sa update()
+ \sa keys()
+*/
+int pump(int theDelayWaitKey = -1);
 
-// Constants regarding mouse buttons
-const int LEFT_BUTTON = 0;
-const int MIDDLE_BUTTON = 1;
-const int RIGHT_BUTTON = 2;
+/**
+ Block until there is input for any window, `cvui::invalidate()` is called or a timeout
+ expires. Applications that mostly sit idle can use it to avoid rendering the same frame
+ over and over again, which drops the CPU usage to almost zero:
 
-// Constants regarding components
-const unsigned int TRACKBAR_HIDE_SEGMENT_LABELS = 1;
-const unsigned int TRACKBAR_HIDE_STEP_SCALE = 2;
-const unsigned int TRACKBAR_DISCRETE = 4;
-const unsigned int TRACKBAR_HIDE_MIN_MAX_LABELS = 8;
-const unsigned int TRACKBAR_HIDE_VALUE_LABEL = 16;
-const unsigned int TRACKBAR_HIDE_LABELS = 32;
+ ```
+ while (true) {
+   // render components
+   bool redraw = cvui::imshow(WINDOW_NAME, frame);
 
-// Describes the block structure used by the lib to handle `begin*()` and `end*()` calls.
+   if (!redraw) {
+     cvui::wait(1000); // Sleep until there is input, but redraw at least once a second.
+   }
+ }
+ ```
+
+ OpenCV events are serviced while waiting (in short `cv::waitKey()` slices), so the
+ interaction latency is the same as in a regular render loop.
+
+ \param theTimeout maximum time to wait, in milliseconds. If a negative value is informed (default), the function waits until there is input or `cvui::invalidate()` is called.
+ \return `true` if there is input or `cvui::invalidate()` was called, `false` if the timeout expired.
+
+ \sa update()
+ \sa invalidate()
+*/
+bool wait(int theTimeout = -1);
+
+/**
+ Tell cvui that all windows need to be redrawn, e.g. because the data being shown changed.
+ It wakes up `cvui::wait()` and makes the next `cvui::update()` of each window return `true`.
+ This function can be called from any thread.
+
+ \sa wait()
+ \sa update()
+*/
+void invalidate();
+
+/**
+ Inform a mouse event to a window as if it came from OpenCV, e.g. to drive the UI of an
+ offscreen context or to benchmark interactions without clicking by hand. The event is
+ queued and applied in the next frame, exactly like events coming from the window system.
+
+ Events are queued in a lock-free queue that accepts a single producer, so inject events
+ from the thread that handles the OpenCV events (the one calling `cv::waitKey()`), or from
+ the thread rendering the window if it is an offscreen context. While the presenter thread
+ is running (see `cvui::startPresenter()`), it is the one handling the OpenCV events, so
+ events must not be injected into the windows it presents: only offscreen contexts accept
+ injected events at that time.
+
+ \param theContext handle of the window that will receive the event.
+ \param theEvent type of the event, e.g. `cvui::EVENT_LBUTTONDOWN` or `cvui::EVENT_MOUSEMOVE`. The values are the same as the ones of `cv::MouseEventTypes`, which is not available without highgui.
+ \param theX x coordinate of the mouse cursor.
+ \param theY y coordinate of the mouse cursor.
+ \param theFlags flags of the event, e.g. the wheel delta in the upper 16 bits for `cvui::EVENT_MOUSEWHEEL`.
+
+ \sa injectKey()
+ \sa record()
+*/
+void injectMouse(cvui_context_t *theContext, int theEvent, int theX, int theY, int theFlags = 0);
+
+/**
+ Inform a key press to a window as if it came from `cv::waitKey()`. The key is queued and handed
+ out in the next frame (see `cvui::keys()`), so it can activate shortcuts, for instance. The same
+ thread rules of `cvui::injectMouse()` apply.
+
+ \param theContext handle of the window that will receive the key.
+ \param theKey code of the key, e.g. `'q'`, like the values returned by `cv::waitKeyEx()`. The code is stored as is, so special keys keep their platform dependent codes (on Windows, for instance, the virtual key code shifted 16 bits to the left).
+
+ \sa injectMouse()
+*/
+void injectKey(cvui_context_t *theContext, int theKey);
+
+/**
+ Start recording the input of a window into a file. Every mouse event and key is stored along with
+ the frame (counted from the start of the recording) in which it was used, so `cvui::replay()` can
+ reproduce the interaction session frame by frame, e.g. to run the same session against different
+ builds when measuring performance. The file uses a compact binary format: a 12-byte header (the
+ magic `CVUIREC2` and a marker of the byte order of the machine that wrote the file) followed by 20-byte
+ records. Recordings can be replayed on machines of either byte order.
+
+ \param theContext handle of the window whose input will be recorded.
+ \param theFilename path of the file the recording will be written to. It is overwritten if it exists.
+ \return `true` if the file could be created, `false` otherwise.
+
+ \sa stopRecording()
+ \sa replay()
+*/
+bool record(cvui_context_t *theContext, const cv::String& theFilename);
+
+/**
+ Stop recording the input of a window, closing the file informed to `cvui::record()`.
+
+ \param theContext handle of the window being recorded.
+
+ \sa record()
+*/
+void stopRecording(cvui_context_t *theContext);
+
+/**
+ Replay the input recorded by `cvui::record()` in a window. Recorded events are applied in the same
+ frames (counted from the start of the replay) they were applied in the recording, so the UI goes
+ through exactly the same states no matter how long each frame takes. Input coming from the window
+ system is ignored while the replay is running.
+
+ \param theContext handle of the window that will receive the recorded input.
+ \param theFilename path of the file created by `cvui::record()`.
+ \return `true` if the file could be read, `false` otherwise.
+
+ \sa replaying()
+ \sa record()
+*/
+bool replay(cvui_context_t *theContext, const cv::String& theFilename);
+
+/**
+ Tell if a replay started by `cvui::replay()` is still running, i.e. if there are recorded events
+ that were not applied yet.
+
+ \param theContext handle of the window that is replaying input.
+ \return `true` if the replay is running, `false` otherwise.
+
+ \sa replay()
+*/
+bool replaying(cvui_context_t *theContext);
+
+/**
+ Return the performance statistics of the last frame of a window, i.e. the frame that ended in the
+ last call to `cvui::update()`. Statistics include the time spent in each category of component
+ (e.g. `cvui::PROFILE_BUTTON`), the amount of draw primitives, text measurements, allocations and cache
+ hits (e.g. `cvui::PROFILE_PRIMITIVES`), the time spent in each component and the duration of recent frames.
+
+ Statistics are only collected if `CVUI_PROFILER` is defined before cvui.h is included in the file where
+ `CVUI_IMPLEMENTATION` is defined. Otherwise the instrumentation is compiled out and all values are zero.
+
+ \param theContext handle of the window whose statistics will be returned. If `nullptr` is informed (default), the current context is used.
+ \return statistics of the last frame of the window.
+
+ \sa profiler()
+*/
+const cvui_profile_t& profile(cvui_context_t *theContext = nullptr);
+
+/**
+ Display the performance statistics of a window (see `cvui::profile()`), i.e. a HUD with the duration of the
+ last frame, a histogram with the percentiles of the duration of recent frames, the counters of the last frame
+ and the components that took longer to render, identified by their ids (see `cvui::id()`).
+
+ \param theWhere image/frame where the HUD will be rendered.
+ \param theX position X where the HUD will be placed.
+ \param theY position Y where the HUD will be placed.
+ \param theTopWidgets amount of components listed in the HUD, ordered by the time they took to render.
+ \param theContext handle of the window whose statistics will be displayed. If `nullptr` is informed (default), the current context is used.
+
+ \sa profile()
+*/
+void profiler(cv::Mat& theWhere, int theX, int theY, int theTopWidgets = 5, cvui_context_t *theContext = nullptr);
+
+/**
+ Keep the zones (e.g. `cvui::update()`, `begin*()`/`end*()` blocks, components and their rendering primitives)
+ of the most recent frames of a window, so they can be saved with `cvui::saveTrace()`. Zones are kept in a
+ ring buffer, i.e. older frames are discarded as new ones are rendered.
+
+ Zones are only measured if `CVUI_PROFILER` is defined before cvui.h is included in the file where
+ `CVUI_IMPLEMENTATION` is defined. Otherwise the instrumentation is compiled out and the trace is always empty.
+
+ \param theFrames amount of recent frames to keep. Use `0` to stop keeping zones.
+ \param theContext handle of the window whose zones will be kept. If `nullptr` is informed (default), the current context is used.
+
+ \sa saveTrace()
+ \sa profile()
+*/
+void trace(int theFrames, cvui_context_t *theContext = nullptr);
+
+/**
+ Save the zones kept by `cvui::trace()` as a Chrome Trace Event JSON file, which can be opened
+ by trace viewers, e.g. `chrome://tracing` or Perfetto. Each zone is a complete event (`"ph":"X"`)
+ whose arguments inform the frame it belongs to and, for components, their id (see `cvui::id()`).
+
+ \param theFilename path of the file where the zones will be saved.
+ \param theContext handle of the window whose zones will be saved. If `nullptr` is informed (default), the current context is used.
+ \return `true` if the file was saved, `false` otherwise.
+
+ \sa trace()
+*/
+bool saveTrace(const cv::String& theFilename, cvui_context_t *theContext = nullptr);
+
+/**
+ Return the amount of heap allocations cvui performed in the last frame of a window, i.e. the frame
+ that ended in the last call to `cvui::update()`. Allocations happen while cvui warms up, e.g. the
+ store of component states grows as components are seen for the first time. Once all components
+ were seen, cvui itself should not allocate at all.
+
+ Only allocations made by cvui code are counted. Allocations made by OpenCV (e.g. inside
+ `cv::putText()`) are not, and neither are those made at the call site before cvui runs: a
+ string literal passed as a label becomes a temporary `cv::String`. On OpenCV 4, `cv::String` is
+ `std::string`, so only labels longer than its small-string buffer (usually 15 characters) allocate.
+ On OpenCV 2.x and 3.x, `cv::String` is a class of its own that allocates for every label that is
+ not empty. Keep labels in `cv::String` variables if that matters.
+
+ \param theContext handle of the window. If `nullptr` is informed (default), the current context is used.
+ \return amount of allocations in the last frame.
+
+ \sa allocationHook()
+ \sa steadyState()
+*/
+unsigned int allocations(cvui_context_t *theContext = nullptr);
+
+/**
+ Set a function to be called whenever cvui allocates memory from the heap, e.g. to log where
+ allocations happen or to feed the statistics of a custom allocator. The hook is called by the
+ thread that allocated, so it must be thread-safe if windows are rendered by several threads.
+ Set the hook before rendering anything.
+
+ \param theHook function to be called, or `nullptr` to remove the current hook.
+ \param theData pointer passed to the hook as is.
+
+ \sa allocations()
+*/
+void allocationHook(cvui_allocation_hook_t theHook, void *theData = nullptr);
+
+/**
+ Turn a window into steady-state mode: after a few warm-up frames, any heap allocation performed by
+ cvui while rendering the window is reported as an error (see `cvui::allocations()`). This is meant
+ for debugging, e.g. to guarantee that a long-running application does not churn the allocator.
+
+ \param theWarmupFrames amount of frames, counted from now, in which allocations are allowed. Use `-1` to leave the steady-state mode.
+ \param theContext handle of the window. If `nullptr` is informed (default), the current context is used.
+
+ \sa allocations()
+*/
+void steadyState(int theWarmupFrames, cvui_context_t *theContext = nullptr);
+
+/**
+ Define what cvui does when it finds an error, e.g. a `beginRow()` closed by `endColumn()`. By default
+ (`cvui::ERROR_EXIT`), the error is printed and the application exits. The other policies do not stop
+ the application: cvui recovers from the error (e.g. blocks left open are closed at `cvui::update()`)
+ and the frame goes on. Errors are counted per frame, see `cvui::errors()`.
+
+ \param thePolicy one of `cvui::ERROR_EXIT`, `cvui::ERROR_EXCEPTION` (a `cvui::cvui_exception_t` is thrown), `cvui::ERROR_CALLBACK` (`theCallback` is called, then cvui recovers) or `cvui::ERROR_RECOVER` (the first error of each code is printed, then cvui recovers).
+ \param theCallback function called for each error if `thePolicy` is `cvui::ERROR_CALLBACK`.
+ \param theData pointer passed to `theCallback` as is.
+
+ \sa errors()
+*/
+void errorPolicy(int thePolicy, cvui_error_callback_t theCallback = nullptr, void *theData = nullptr);
+
+/**
+ Return the amount of errors cvui found in the last frame of a window, i.e. the frame that ended
+ in the last call to `cvui::update()`. Only useful if the error policy lets the application go on
+ after an error, see `cvui::errorPolicy()`.
+
+ \param theContext handle of the window. If `nullptr` is informed (default), the current context is used.
+ \return amount of errors in the last frame.
+
+ \sa errorPolicy()
+*/
+unsigned int errors(cvui_context_t *theContext = nullptr);
+
+/**
+ Start a presenter thread, which takes care of showing the windows and handling their events, so
+ the thread(s) rendering the UI never block on the window system. Frames are handed to the presenter
+ by `cvui::present()` through a lock-free triple buffer, without copies, and input flows back into the
+ windows through their (lock-free) event queues.
+
+ The presenter creates the windows and sets their mouse callbacks itself, because some window systems
+ require all calls to come from a single thread. For that reason, call this function **before**
+ `cvui::init()`/`cvui::watch()`. While the presenter is running, `cvui::update()` no longer calls
+ `cv::waitKey()`, and the application must not call `cv::imshow()`/`cv::waitKey()` itself, nor
+ `cvui::injectMouse()`/`cvui::injectKey()` for the windows being presented: the presenter is the only
+ producer of their event queues.
+
+ \param theDelayWaitKey delay value passed to `cv::waitKey()` by the presenter thread in each iteration.
+
+ \sa present()
+ \sa stopPresenter()
+*/
+void startPresenter(int theDelayWaitKey = 1);
+
+/**
+ Stop the presenter thread started by `cvui::startPresenter()` and wait for it to finish.
+ It is called automatically when the application exits.
+
+ \sa startPresenter()
+*/
+void stopPresenter();
+
+/**
+ Update the internal structures of cvui regarding a window, i.e. call `cvui::update()`, then hand
+ the frame over to the presenter thread, which shows it asynchronously. The frame is not copied:
+ its content is moved to the presenter and `theFrame` receives a buffer of the same size and type
+ that is no longer in use, which can be used to render the next frame. As a consequence, the content
+ of `theFrame` is undefined after this call, so render everything again in the next frame.
+
+ If the presenter thread is not running, this function behaves like `cvui::imshow()`.
+
+ \param theContext handle of the window that will be shown.
+ \param theFrame image, i.e. `cv::Mat`, to be shown in the window. It receives a buffer to render the next frame into.
+ \return `true` if the window needs to be redrawn, as returned by `cvui::update()`.
+
+ \sa startPresenter()
+ \sa imshow()
+*/
+bool present(cvui_context_t *theContext, cv::Mat& theFrame);
+
+/**
+ Update the internal structures of cvui regarding a window, then hand the frame over to the presenter
+ thread. This function behaves exactly like `cvui::present(cvui_context_t*, cv::Mat&)`, however the window
+ is informed by its name.
+
+ \param theWindowName name of the window that will be shown.
+ \param theFrame image, i.e. `cv::Mat`, to be shown in the window. It receives a buffer to render the next frame into.
+ \return `true` if the window needs to be redrawn, as returned by `cvui::update()`.
+
+ \sa startPresenter()
+*/
+bool present(const cv::String& theWindowName, cv::Mat& theFrame);
+
+/**
+ Return the UI layer of a window, a `CV_8UC4` image where components can be rendered instead of being
+ rendered directly on the frames of a video. The layer is blended over every frame shown by `cvui::imshow()`
+ or `cvui::present()` (see `cvui::composite()`), so the UI only needs to be rendered again when it changes,
+ i.e. when `cvui::update()` (or `cvui::imshow()`) returns `true`:
+
+ ```
+ bool dirty = true;
+ while (camera.read(frame)) {
+   if (dirty) {
+     cv::Mat& ui = cvui::layer(frame.size());
+     cvui::button(ui, 10, 10, "Button");
+   }
+   dirty = cvui::imshow(WINDOW_NAME, frame);
+ }
+ ```
+
+ Each call clears the layer, i.e. makes it fully transparent. Its pixels have premultiplied colors and
+ the usual alpha of BGRA images (`0` is transparent, `255` is opaque), which is what components produce
+ when rendered on a cleared layer.
+
+ \param theSize size of the layer, usually the size of the frames. If an empty size is informed, the layer is removed.
+ \param theContext handle of the window. If `nullptr` is informed (default), the current context is used.
+ \return the layer of the window, where components should be rendered.
+
+ \sa composite()
+*/
+cv::Mat& layer(cv::Size theSize, cvui_context_t *theContext = nullptr);
+
+/**
+ Blend the UI layer of a window over a frame, in place. `cvui::imshow()` and `cvui::present()` already do
+ it, so this function is only needed if the frame is shown by other means, e.g. `cv::imshow()`. Rows of
+ the layer without any component are skipped, so the cost is proportional to the area covered by the UI.
+
+ \param theFrame frame where the layer is blended, either `CV_8UC3` or `CV_8UC4`. If it is larger than the layer, the layer is blended over its top-left area.
+ \param theContext handle of the window. If `nullptr` is informed (default), the current context is used.
+
+ \sa layer()
+*/
+void composite(cv::Mat& theFrame, cvui_context_t *theContext = nullptr);
+
+// Internally used to handle mouse events
+void handleMouse(int theEvent, int theX, int theY, int theFlags, void* theData);
+
+// Compatibility macros to allow compilation with either OpenCV 2.x or OpenCV 3.x
+#if (CV_MAJOR_VERSION < 3)
+	#define CVUI_ANTIALISED CV_AA
+#else
+	#define CVUI_ANTIALISED cv::LINE_AA
+#endif
+#define CVUI_FILLED -1
+
+// If we are not in a Windows-based environment, replace Windows-specific functions with
+// their POSIX equivalents.
+#if !defined(_MSC_VER)
+	#define vsprintf_s vsprintf
+	#define sprintf_s sprintf
+#endif
+
+// Adjust things accoridng to platform
+#ifdef _MSC_VER
+	#define _CVUI_COMPILE_MESSAGE(x) message(x)
+
+	// If windows.h has already been included, min() and max() will be defined.
+	// In such case, a shit storm will rain on us, producing all kinds of
+	// compilation problems with cvui. If min/max are already defined,
+	// let's undef them for now and redef them at the end of this file.
+	#ifdef min
+		#define __cvui_min min
+		#undef min
+	#endif
+	#ifdef max
+		#define __cvui_max max
+		#undef max
+	#endif
+#elif __GNUC__
+	#define _CVUI_COMPILE_MESSAGE(x) message x
+#endif
+
+// Some compilation messages
+#define _CVUI_IMPLEMENTATION_NOTICE "cvui.h: compiling implementation because of CVUI_IMPLEMENTATION. See: https://dovyski.github.io/cvui/usage/"
+#define _CVUI_NO_IMPLEMENTATION_NOTICE "cvui.h: implementation skipped. Ensure one of your C++ files included cvui.h after a #define CVUI_IMPLEMENTATION. See: https://dovyski.github.io/cvui/usage/"
+
+// Below is paranoic, dramatic bug-fixing action to ensure no evil macro
+// have already defined our names. For some bizarre reason, cvui did not
+// compile in one of my projects because OUT was already defined. So be it.
+#undef VERSION
+#undef ROW
+#undef COLUMN
+#undef DOWN
+#undef CLICK
+#undef OVER
+#undef OUT
+#undef UP
+#undef IS_DOWN
+#undef LEFT_BUTTON
+#undef MIDDLE_BUTTON
+#undef RIGHT_BUTTON
+
+// Check for Unix stuff
+#ifdef __GNUC__
+	// just to remove the warning under gcc that is introduced by the VERSION variable below
+	// (needed for those who compile with -Werror (make warning as errors)
+	#pragma GCC diagnostic ignored "-Wunused-variable"
+#endif
+
+// Lib version
+static const char *VERSION = "2.7.0";
+
+const int ROW = 0;
+const int COLUMN = 1;
+const int DOWN = 2;
+const int CLICK = 3;
+const int OVER = 4;
+const int OUT = 5;
+const int UP = 6;
+const int IS_DOWN = 7;
+
+// Constants regarding mouse buttons
+const int LEFT_BUTTON = 0;
+const int MIDDLE_BUTTON = 1;
+const int RIGHT_BUTTON = 2;
+
+// Mouse events, see cvui::injectMouse(). Same values as cv::MouseEventTypes, which
+// is part of highgui, thus not available when CVUI_HEADLESS is defined.
+const int EVENT_MOUSEMOVE = 0;
+const int EVENT_LBUTTONDOWN = 1;
+const int EVENT_RBUTTONDOWN = 2;
+const int EVENT_MBUTTONDOWN = 3;
+const int EVENT_LBUTTONUP = 4;
+const int EVENT_RBUTTONUP = 5;
+const int EVENT_MBUTTONUP = 6;
+const int EVENT_MOUSEWHEEL = 10;
+const int EVENT_MOUSEHWHEEL = 11;
+
+// Constants regarding components
+const unsigned int TRACKBAR_HIDE_SEGMENT_LABELS = 1;
+const unsigned int TRACKBAR_HIDE_STEP_SCALE = 2;
+const unsigned int TRACKBAR_DISCRETE = 4;
+const unsigned int TRACKBAR_HIDE_MIN_MAX_LABELS = 8;
+const unsigned int TRACKBAR_HIDE_VALUE_LABEL = 16;
+const unsigned int TRACKBAR_HIDE_LABELS = 32;
+
+// Modifier keys, see cvui_key_event_t::modifiers
+const int KEY_SHIFT = 1;
+const int KEY_CTRL = 2;
+const int KEY_ALT = 4;
+
+// Policies regarding errors, see cvui::errorPolicy()
+const int ERROR_EXIT = 0;
+const int ERROR_EXCEPTION = 1;
+const int ERROR_CALLBACK = 2;
+const int ERROR_RECOVER = 3;
+
+// Categories of components measured by the profiler, see cvui::profile()
+const int PROFILE_BUTTON = 0;
+const int PROFILE_TEXT = 1;
+const int PROFILE_TRACKBAR = 2;
+const int PROFILE_SPARKLINE = 3;
+const int PROFILE_WINDOW = 4;
+const int PROFILE_IMAGE = 5;
+const int PROFILE_RECT = 6;
+const int PROFILE_CHECKBOX = 7;
+const int PROFILE_COUNTER = 8;
+const int PROFILE_TABLE = 9;
+const int PROFILE_ANNOTATIONS = 10;
+const int PROFILE_CATEGORIES = 11;
+
+// Counters of the profiler, see cvui::profile()
+const int PROFILE_PRIMITIVES = 0;
+const int PROFILE_TEXT_MEASUREMENTS = 1;
+const int PROFILE_ALLOCATIONS = 2;
+const int PROFILE_CACHE_HITS = 3;
+const int PROFILE_COUNTERS = 4;
+
+// Parts of components that can be skinned, see cvui::skin()
+const int SKIN_BUTTON = 0;
+const int SKIN_WINDOW_TITLE = 1;
+const int SKIN_WINDOW = 2;
+const int SKIN_TRACKBAR = 3;
+const int SKIN_TRACKBAR_HANDLE = 4;
+const int SKIN_TYPES = 5;
+
+// Colors of a theme, see cvui::theme()
+const int THEME_TEXT = 0;                        // text of components, e.g. labels and titles, i.e. cvui::DEFAULT_TEXT_COLOR.
+const int THEME_TEXT_DARK = 1;                   // labels of buttons with a bright color.
+const int THEME_BUTTON = 2;                      // inside of buttons, i.e. cvui::DEFAULT_BUTTON_COLOR.
+const int THEME_BUTTON_BEVEL = 3;                // added to (and subtracted from) the inside of buttons for their 3D outline.
+const int THEME_BUTTON_HIGHLIGHT = 4;            // added to the inside of buttons under the mouse, subtracted from pressed ones.
+const int THEME_COUNTER = 5;
+const int THEME_COUNTER_BORDER = 6;
+const int THEME_TRACKBAR = 7;                    // path of trackbars.
+const int THEME_TRACKBAR_BORDER = 8;
+const int THEME_TRACKBAR_BORDER_OVER = 9;
+const int THEME_TRACKBAR_SHADOW = 10;
+const int THEME_TRACKBAR_STEPS = 11;             // ticks of steps and segments.
+const int THEME_TRACKBAR_HANDLE = 12;
+const int THEME_TRACKBAR_HANDLE_OVER = 13;
+const int THEME_TRACKBAR_HANDLE_BORDER = 14;
+const int THEME_TRACKBAR_HANDLE_OUTLINE = 15;
+const int THEME_CHECKBOX = 16;                   // inside of checkboxes.
+const int THEME_CHECKBOX_BORDER = 17;
+const int THEME_CHECKBOX_OUTLINE = 18;
+const int THEME_CHECKBOX_OUTLINE_OVER = 19;
+const int THEME_CHECKBOX_CHECK = 20;
+const int THEME_WINDOW = 21;                     // body of windows.
+const int THEME_WINDOW_BORDER = 22;
+const int THEME_WINDOW_TITLE = 23;               // title bar of windows.
+const int THEME_TABLE = 24;                      // body of tables.
+const int THEME_TABLE_HEADER = 25;
+const int THEME_TABLE_SELECTION = 26;
+const int THEME_TABLE_SEPARATOR = 27;
+const int THEME_TABLE_BORDER = 28;
+const int THEME_TABLE_SCROLLBAR = 29;
+const int THEME_TABLE_THUMB = 30;
+const int THEME_COLORS = 31;
+
+// Colors derived from the ones of a theme when it is set, see cvui::theme()
+const int THEME_BUTTON_BRIGHT = THEME_COLORS;    // 3D outline of buttons on the side the light comes from.
+const int THEME_BUTTON_DARK = THEME_COLORS + 1;  // 3D outline of buttons on the other side.
+const int THEME_BUTTON_OVER = THEME_COLORS + 2;  // inside of buttons under the mouse.
+const int THEME_BUTTON_DOWN = THEME_COLORS + 3;  // inside of pressed buttons.
+const int THEME_BUTTON_LABEL = THEME_COLORS + 4; // labels of buttons, either THEME_TEXT or THEME_TEXT_DARK.
+const int THEME_SCALARS = THEME_COLORS + 5;
+
+// Describes the block structure used by the lib to handle `begin*()` and `end*()` calls.
 typedef struct {
 	cv::Mat where;			// where the block should be rendered to.
 	cv::Rect rect;			// the size and position of the block.
@@ -1160,6 +2082,7 @@ typedef struct {
 	cv::Point anchor;		// the point where the next component of the block should be rendered.
 	int padding;			// padding among components within this block.
 	int type;				// type of the block, e.g. ROW or COLUMN.
+	int64 start;			// moment the block was created by begin*(), in ticks. Only used by the profiler.
 } cvui_block_t;
 
 // Describes a component label, including info about a shortcut.
@@ -1175,6 +2098,28 @@ typedef struct {
 	std::string textAfterShortcut;
 } cvui_label_t;
 
+// Describes the state of a table component across frames. The caller keeps one
+// of these for each table and cvui stores the scroll position, the selected row
+// and the formatted text of the visible cells in it. Cache slots are indexed by
+// row % capacity, so scrolling by a row only formats the row that became visible.
+struct cvui_table_t {
+	int scroll;                      // index of the first visible row.
+	int selected;                    // index of the selected row, or -1 if no row is selected.
+	int rows;                        // amount of rows informed in the last frame.
+	int columns;                     // amount of columns informed in the last frame.
+	int capacity;                    // amount of rows the cache can hold, i.e. visible rows.
+	std::vector<int> cachedRows;     // row held by each cache slot, or -1 if the slot is empty.
+	std::vector<cv::String> cells;   // formatted text of the cached cells, indexed by slot * columns + column.
+
+	inline cvui_table_t()
+		: scroll(0)
+		, selected(-1)
+		, rows(0)
+		, columns(0)
+		, capacity(0)
+	{}
+};
+
 // Describe a mouse button
 typedef struct {
 	bool justReleased;          // if the mouse button was released, i.e. click event.
@@ -1187,26 +2132,282 @@ typedef struct {
 	cvui_mouse_btn_t buttons[3]; // status of each button. Use cvui::{RIGHT,LEFT,MIDDLE}_BUTTON to access the buttons.
 	cvui_mouse_btn_t anyButton;  // represent the behavior of all mouse buttons combined
 	cv::Point position;          // x and y coordinates of the mouse at the moment.
+	int wheel;                   // amount the mouse wheel was scrolled since the last frame (positive means forward).
 } cvui_mouse_t;
 
-// Describes a (window) context.
+// Describes a mouse event received from OpenCV (HighGUI).
+typedef struct {
+	int type;                    // type of the event, e.g. cvui::EVENT_LBUTTONDOWN.
+	cv::Point position;          // x and y coordinates of the mouse when the event happened.
+	int wheel;                   // amount the mouse wheel was scrolled, if the event is a wheel event.
+	int64 timestamp;             // moment the event was received, in ticks (see cv::getTickCount()).
+} cvui_mouse_event_t;
+
+// Describes a sample of the mouse motion, i.e. a position the mouse cursor went through.
+struct cvui_mouse_sample_t {
+	cv::Point position;          // x and y coordinates of the mouse cursor.
+	bool pressed;                // if any mouse button was pressed at that moment.
+	bool carried;                // if the sample is the last one of a previous frame, which starts the samples of this frame.
+	int64 timestamp;             // moment the sample was taken, in ticks (see cv::getTickCount()).
+};
+
+// Describes a key pressed in a window.
+struct cvui_key_event_t {
+	int key;                     // the key as returned by cv::waitKey(), e.g. 'a' or 27 (ESC), i.e. the lowest 8 bits of code.
+	int code;                    // full code of the key, as returned by cv::waitKeyEx(). Codes of special keys (arrows, F1, etc.) and the state kept in the upper bits are platform dependent.
+	int modifiers;               // modifier keys held down, e.g. KEY_SHIFT | KEY_CTRL. Only reported by the GTK backend of OpenCV, always 0 otherwise.
+	int64 timestamp;             // moment the key was received, in ticks (see cv::getTickCount()).
+	bool consumed;               // if the key was already used by a component, e.g. as a shortcut.
+};
+
+// Describes an input event stored in a recording, see cvui::record().
+// It has 20 bytes, which is also its size in recording files.
+typedef struct {
+	uint32_t frame;              // frame, counted from the start of the recording, in which the event was used.
+	int16_t kind;                // 0 for mouse events, 1 for keys.
+	int16_t type;                // type of the mouse event (e.g. cvui::EVENT_LBUTTONDOWN). Always 0 for keys.
+	int32_t x;                   // x coordinate of the mouse cursor.
+	int32_t y;                   // y coordinate of the mouse cursor.
+	int32_t value;               // wheel delta of the mouse event or code of the key.
+} cvui_input_record_t;
+
+// Lock-free triple buffer used to hand frames over to the presenter thread. The producer
+// owns buffers[back] and the presenter owns buffers[front]. The third buffer is exchanged
+// between them through middle, whose FRESH bit tells if it holds a frame not yet shown.
+struct cvui_triple_buffer_t {
+	static const int FRESH = 4;
+
+	cv::Mat buffers[3];
+	int back;                    // index of the buffer owned by the producer.
+	int front;                   // index of the buffer owned by the presenter.
+	std::atomic<int> middle;     // index of the buffer in between, possibly with the FRESH bit.
+
+	inline cvui_triple_buffer_t()
+		: back(0)
+		, front(1)
+		, middle(2)
+	{}
+};
+
+// Lock-free ring buffer with a single producer, e.g. the HighGUI callbacks, and a
+// single consumer, e.g. the thread calling cvui::update() for a window. One slot is
+// always kept empty to tell a full ring from an empty one.
+template<typename T, size_t N>
+struct cvui_ring_t {
+	T items[N];
+	std::atomic<size_t> head;    // index of the next item to be read. Only changed by the consumer.
+	std::atomic<size_t> tail;    // index of the next item to be written. Only changed by the producer.
+	std::atomic<unsigned int> dropped; // amount of items discarded because the ring was full.
+
+	inline cvui_ring_t()
+		: head(0)
+		, tail(0)
+		, dropped(0)
+	{}
+};
+
+// Describes the state of a widget that is kept across frames. Widgets are
+// identified by their id (see cvui::id()) and their state lives in the
+// context of the window they belong to.
+struct cvui_widget_t {
+	unsigned int id;             // id of the widget. Zero means the state is not in use.
+	unsigned int frame;          // last frame in which the state was used.
+	bool active;                 // if the widget is active, e.g. being dragged.
+	cv::Point anchor;            // a point of interest, e.g. where a drag started.
+	double value;                // a value of interest, e.g. a scroll offset.
+	cv::Mat cache;               // cached content of the widget, e.g. a pre-rendered bitmap.
+	void *data;                  // any data attached to the widget.
+
+	inline cvui_widget_t()
+		: id(0)
+		, frame(0)
+		, active(false)
+		, value(0)
+		, data(nullptr)
+	{}
+};
+
+// Hash map of widget states indexed by widget id. It uses open addressing
+// with linear probing, so its capacity is always a power of two.
+typedef struct {
+	std::vector<cvui_widget_t> slots; // all slots of the map, used or not.
+	size_t count;                     // amount of slots in use.
+} cvui_widget_store_t;
+
+// A skin stretched to a given size, see cvui::skin().
+typedef struct {
+	cv::Size size;               // size the skin was stretched to.
+	int type;                    // type of the image the skin is rendered into, e.g. CV_8UC3.
+	cv::Mat image;               // stretched skin, already in the type of the image it is rendered into.
+	cv::Mat alpha;               // opacity of each pixel of the stretched skin, or empty if the skin is opaque.
+	unsigned int use;            // frame the stretched skin was last used in (see gSkinFrame), so unused sizes are dropped.
+} cvui_skin_cache_t;
+
+// Describes a nine-slice skin of a component, see cvui::skin().
+typedef struct {
+	cv::Mat image;               // image of the skin, or empty if there is no skin.
+	int left, top, right, bottom; // borders of the image that are not stretched.
+	std::vector<cvui_skin_cache_t> cache; // image stretched to the sizes it was rendered at recently.
+} cvui_skin_t;
+
+// Describes the time a component took to render in a frame.
+typedef struct {
+	unsigned int id;             // id of the component, see cvui::id().
+	int category;                // category of the component, e.g. cvui::PROFILE_BUTTON.
+	double time;                 // time spent in the component itself, without components it rendered (e.g. the buttons of a counter), in milliseconds.
+} cvui_profile_widget_t;
+
+// Describes the performance statistics of a frame, see cvui::profile().
+struct cvui_profile_t {
+	double frameTime;                            // time between the last two calls to cvui::update(), in milliseconds.
+	double time[PROFILE_CATEGORIES];             // time spent in each category of component, in milliseconds. Nested components are only counted in their own category.
+	unsigned int calls[PROFILE_CATEGORIES];      // amount of components rendered in each category.
+	unsigned int counters[PROFILE_COUNTERS];     // value of each counter, e.g. cvui::PROFILE_PRIMITIVES.
+	std::vector<cvui_profile_widget_t> widgets;  // time spent in each component, in the order they were rendered.
+	std::vector<double> history;                 // duration of the most recent frames, in milliseconds. Once full, it is a ring whose oldest frame is at historyNext.
+	size_t historyNext;                          // position of history where the duration of the next frame is written.
+
+	inline cvui_profile_t()
+		: frameTime(0)
+		, time()
+		, calls()
+		, counters()
+		, historyNext(0)
+	{}
+};
+
+// Describes a zone of a frame, e.g. a component, see cvui::trace().
+typedef struct {
+	const char *name;            // name of the zone, e.g. "button" or "render::button".
+	unsigned int id;             // id of the component related to the zone, or zero.
+	int64 start;                 // moment the zone started, in ticks.
+	int64 end;                   // moment the zone ended, in ticks.
+} cvui_trace_event_t;
+
+// Describes the zones of a frame, see cvui::trace().
 typedef struct {
+	unsigned int frame;          // frame the zones belong to.
+	std::vector<cvui_trace_event_t> events; // zones of the frame, in the order they ended.
+} cvui_trace_frame_t;
+
+// Describes the look of components, see cvui::theme(). Colors are in the format 0xRRGGBB
+// and indexed by cvui::THEME_TEXT, cvui::THEME_BUTTON, etc. A new theme has the default
+// look of cvui (already prepared), so only what changes has to be informed. cvui::theme()
+// prepares themes whose colors changed.
+struct cvui_theme_t {
+	unsigned int colors[THEME_COLORS];   // colors of components.
+	double fontScale;                    // default size of text, which becomes cvui::DEFAULT_FONT_SCALE.
+	int trackbarHeight;                  // height of the path of trackbars, in pixels.
+	int windowTitleHeight;               // height of the title bar of windows whose title uses fontScale, in pixels.
+	cv::Scalar scalars[THEME_SCALARS];   // colors ready to be rendered, including the derived ones, e.g. cvui::THEME_BUTTON_OVER. Computed by prepare().
+	unsigned int prepared[THEME_COLORS]; // colors the scalars were computed from, so cvui::theme() can tell if prepare() is due.
+
+	// Compute the scalars from the colors. cvui::theme() calls it if the colors changed since the last call.
+	void prepare();
+
+	// Tell if the colors changed since the last call to prepare().
+	bool dirty() const;
+
+	inline cvui_theme_t()
+		: colors{
+			0xCECECE, 0x323232, 0x424242, 0x505050, 0x101010,
+			0x292929, 0x454545,
+			0x292929, 0x3E3E3E, 0x4E4E4E, 0x0E0E0E, 0x515151, 0x424242, 0x525252, 0x212121, 0x515151,
+			0x292929, 0x171717, 0x636363, 0x808080, 0x75BFFF,
+			0x313131, 0x4A4A4A, 0x212121,
+			0x292929, 0x212121, 0x3A6080, 0x3E3E3E, 0x4A4A4A, 0x212121, 0x4A4A4A }
+		, fontScale(0.4)
+		, trackbarHeight(7)
+		, windowTitleHeight(20)
+		, scalars()
+		, prepared()
+	{
+		prepare();
+	}
+};
+
+// Describes a (window) context.
+struct cvui_context_t {
 	cv::String windowName;       // name of the window related to this context.
 	cvui_mouse_t mouse;          // the mouse cursor related to this context.
-} cvui_context_t;
+	cvui_widget_store_t widgets; // state of the widgets of this window, indexed by their ids.
+	cvui_widget_store_t labels;  // rendered labels of cvui::annotations(), indexed by a hash of their text and style.
+	std::vector<unsigned int> idScopes; // ids pushed by cvui::pushId().
+	unsigned int nextId;         // explicit id of the next widget, informed by cvui::id(), or zero.
+	unsigned int lastId;         // id of the last widget rendered in this window.
+	unsigned int frame;          // amount of frames, i.e. calls to cvui::update(), of this window.
+	cvui_block_t screen;         // block used by components rendered at explicit x,y coordinates.
+	std::vector<cvui_block_t> stack; // blocks created by begin*() calls.
+	int stackCount;              // index of the block at the top of the stack, or -1 if the stack is empty.
+	cvui_ring_t<cvui_mouse_event_t, 256> mouseEvents; // mouse events received but not yet applied to the mouse state.
+	cvui_ring_t<cvui_key_event_t, 64> keyEvents; // keys received but not yet handed out to a frame.
+	std::atomic<int64> mouseActivity; // moment of the most recent mouse event received, in ticks.
+	bool inputPolled;            // if the queued input was already taken for the current frame.
+	std::atomic<bool> invalidated; // if the window must be redrawn, i.e. cvui::invalidate() was called.
+	std::atomic<bool> pumped;    // if cvui::pump() serviced the events since the last update() of the window.
+	cvui_triple_buffer_t frames; // frames handed over to the presenter thread by cvui::present().
+	bool presented;              // if the window is in the list of windows of the presenter thread.
+	bool windowReady;            // if the presenter thread already created the window. Only used by the presenter thread.
+	bool offscreen;              // if the context is not attached to a window, see cvui::offscreen().
+	FILE *recording;             // file input is being recorded into, see cvui::record(), or nullptr.
+	unsigned int recordingStart; // frame in which the recording started.
+	std::vector<cvui_input_record_t> replay; // input being replayed, see cvui::replay().
+	size_t replayNext;           // index of the next record to be replayed.
+	unsigned int replayStart;    // frame in which the replay started.
+	cvui_profile_t profile;      // statistics of the frame being rendered. Only collected if CVUI_PROFILER is defined.
+	cvui_profile_t lastProfile;  // statistics of the last complete frame.
+	int64 profileStart;          // moment the frame being rendered started, in ticks.
+	std::vector<cvui_trace_frame_t> trace; // zones of the most recent frames, indexed by frame, see cvui::trace().
+	unsigned int allocations;    // heap allocations performed by cvui in the frame being rendered.
+	unsigned int lastAllocations; // heap allocations performed by cvui in the last complete frame.
+	unsigned int errors;         // errors found in the frame being rendered, see cvui::errorPolicy().
+	unsigned int lastErrors;     // errors found in the last complete frame.
+	bool steadyState;            // if allocations are errors after steadyStateStart, see cvui::steadyState().
+	unsigned int steadyStateStart; // first frame in which allocations are errors.
+	std::vector<cvui_mouse_sample_t> mouseSamples; // positions the mouse went through in the current frame. Bounded by the size of mouseEvents.
+	cvui_mouse_sample_t carriedSample; // last sample of the last frame with motion, which starts the samples of the next one.
+	bool hasCarriedSample;       // if there was any sample yet, i.e. carriedSample is valid.
+	std::vector<cvui_key_event_t> keys; // keys pressed in the current frame. Bounded by the size of keyEvents.
+	cv::Mat layer;               // UI layer blended over the frames of the window, see cvui::layer().
+	cv::Mat composited;          // frame shown by cvui::imshow() when there is a UI layer.
+	std::vector<uchar> layerRows; // if each row of the layer has any visible pixel. Empty if the layer changed since it was scanned.
+
+	inline cvui_context_t()
+		: mouse()
+		, widgets()
+		, labels()
+		, nextId(0)
+		, lastId(0)
+		, frame(0)
+		, screen()
+		, stackCount(-1)
+		, mouseActivity(0)
+		, inputPolled(false)
+		, invalidated(false)
+		, pumped(false)
+		, presented(false)
+		, windowReady(false)
+		, offscreen(false)
+		, recording(nullptr)
+		, recordingStart(0)
+		, replayNext(0)
+		, replayStart(0)
+		, profileStart(0)
+		, allocations(0)
+		, lastAllocations(0)
+		, errors(0)
+		, lastErrors(0)
+		, steadyState(false)
+		, steadyStateStart(0)
+		, carriedSample()
+		, hasCarriedSample(false)
+	{}
+};
 
 // Internal namespace with all code that is shared among components/functions.
 // You should probably not be using anything from here.
 namespace internal
 {
-	static cv::String gDefaultContext;
-	static cv::String gCurrentContext;
-	static std::map<cv::String, cvui_context_t> gContexts; // indexed by the window name.
-	static char gBuffer[1024];
-	static int gLastKeyPressed; // TODO: collect it per window
-	static int gDelayWaitKey;
-	static cvui_block_t gScreen;
-
 	struct TrackbarParams {
 		long double min;
 		long double max;
@@ -1227,16 +2428,101 @@ namespace internal
 		{}
 	};
 
-	static cvui_block_t gStack[100]; // TODO: make it dynamic?
-	static int gStackCount = -1;
 	static const int gTrackbarMarginX = 14;
 
+	static const unsigned int gWidgetLifetime = 300; // frames a widget state survives without being used.
+	static const unsigned int gSkinLifetime = 300; // frames (of all windows) a stretched skin survives without being used.
+	static const unsigned int gHashSeed = 2166136261u;
+
 	bool isMouseButton(cvui_mouse_btn_t& theButton, int theQuery);
+	cvui_mouse_btn_t& mouseButton(cvui_context_t& theContext, int theButton);
 	void resetMouseButton(cvui_mouse_btn_t& theButton);
+	cvui_context_t& input(cvui_context_t& theContext);
+	void applyMouseEvent(cvui_mouse_t& theMouse, const cvui_mouse_event_t& theEvent);
+	int mouseEventButton(int theType, bool *theDown);
+	void queueKey(cvui_context_t& theContext, int theKey);
+	cvui_key_event_t keyEvent(int theCode, int64 theTimestamp);
+	bool consumeShortcut(cvui_context_t& theContext, const cv::String& theLabel);
+	int waitKey(int theDelay);
+	void resetInput(cvui_context_t& theContext);
+	bool hasPendingInput(cvui_context_t& theContext);
+	void presenterLoop(int theDelayWaitKey);
+	cvui_context_t *createContext(const cv::String& theName, bool theOffscreen);
+	void useMouseEvent(cvui_context_t& theContext, const cvui_mouse_event_t& theEvent);
+	void useKey(cvui_context_t& theContext, const cvui_key_event_t& theKey);
+	void replayInput(cvui_context_t& theContext);
+	void swapRecord(cvui_input_record_t& theRecord);
+	void profileZone(int theCategory, int64 theStart, int64 theNested);
+	void profileCount(int theCounter);
+	void profileFrame(cvui_context_t& theContext);
+	void traceZone(cvui_context_t& theContext, unsigned int theFrame, const char *theName, unsigned int theId, int64 theStart, int64 theEnd);
+	void writeJsonString(FILE *theFile, const char *theText);
+	static const size_t gProfileHistory = 240; // amount of frames kept in the history of the profiler.
+	static const char *gProfileCategories[PROFILE_CATEGORIES] = { "button", "text", "trackbar", "sparkline", "window", "image", "rect", "checkbox", "counter", "table", "annotations" };
+
+#ifdef CVUI_PROFILER
+	// Measures the time spent in a component, from its creation to the end of the scope. Zones of
+	// components rendered by other components (e.g. the buttons of a counter) are nested, and their
+	// time is only counted in the innermost zone.
+	struct ProfileZone {
+		int category;
+		int64 start;
+		int64 nested;            // ticks spent in zones nested in this one.
+		ProfileZone *parent;     // zone this one is nested in, or nullptr.
+
+		inline ProfileZone(int theCategory);
+		inline ~ProfileZone();
+	};
+
+	static thread_local ProfileZone *gProfileZone = nullptr; // innermost zone open in this thread.
+
+	inline ProfileZone::ProfileZone(int theCategory) : category(theCategory), start(cv::getTickCount()), nested(0), parent(gProfileZone) {
+		gProfileZone = this;
+	}
+
+	inline ProfileZone::~ProfileZone() {
+		gProfileZone = parent;
+		internal::profileZone(category, start, nested);
+
+		if (parent != nullptr) {
+			parent->nested += cv::getTickCount() - start;
+		}
+	}
+
+	// Keeps a zone (e.g. a rendering primitive) in the trace of the frame it started in, see cvui::trace().
+	struct TraceZone {
+		cvui_context_t& context;
+		const char *name;
+		unsigned int frame;
+		int64 start;
+
+		inline TraceZone(cvui_context_t& theContext, const char *theName) : context(theContext), name(theName), frame(theContext.frame), start(theContext.trace.empty() ? 0 : cv::getTickCount()) {}
+		inline ~TraceZone() { if (start != 0) internal::traceZone(context, frame, name, 0, start, cv::getTickCount()); }
+	};
+
+	#define CVUI_PROFILE_ZONE(theCategory) cvui::internal::ProfileZone aProfileZone(theCategory)
+	#define CVUI_PROFILE_COUNT(theCounter) cvui::internal::profileCount(theCounter)
+	#define CVUI_TRACE_ZONE(theContext, theName) cvui::internal::TraceZone aTraceZone(theContext, theName)
+#else
+	#define CVUI_PROFILE_ZONE(theCategory)
+	#define CVUI_PROFILE_COUNT(theCounter)
+	#define CVUI_TRACE_ZONE(theContext, theName)
+#endif
+	static const char gRecordingMagic[8] = { 'C', 'V', 'U', 'I', 'R', 'E', 'C', '2' };
+	static const uint32_t gRecordingByteOrder = 0x01020304; // written after the magic, reads 0x04030201 in the other byte order.
 	void init(const cv::String& theWindowName, int theDelayWaitKey);
-	cvui_context_t& getContext(const cv::String& theWindowName = "");
+	cvui_context_t& getContext();
+	cvui_context_t& getContext(const cv::String& theWindowName);
+	cvui_block_t& screen(cv::Mat& theWhere);
+	unsigned int hash(const void *theData, size_t theSize, unsigned int theSeed);
+	unsigned int widgetId(const char *theLabel, int theX, int theY);
+	cvui_widget_t& widget(cvui_context_t& theContext, unsigned int theId);
+	cvui_widget_t& widget(cvui_widget_store_t& theStore, unsigned int theId, unsigned int theFrame);
+	void rehashWidgets(cvui_widget_store_t& theStore, unsigned int theFrame);
 	bool bitsetHas(unsigned int theBitset, unsigned int theValue);
-	void error(int theId, std::string theMessage);
+	void error(int theId, const char *theMessage);
+	void error(cvui_context_t& theContext, int theId, const char *theMessage);
+	void raise(int theId, const char *theMessage);
 	void updateLayoutFlow(cvui_block_t& theBlock, cv::Size theSize);
 	bool blockStackEmpty();
 	cvui_block_t& topBlock();
@@ -1244,7 +2530,11 @@ namespace internal
 	cvui_block_t& popBlock();
 	void begin(int theType, cv::Mat &theWhere, int theX, int theY, int theWidth, int theHeight, int thePadding);
 	void end(int theType);
-	cvui_label_t createLabel(const std::string &theLabel);
+	const cvui_label_t& createLabel(const std::string &theLabel);
+	const std::string& bufferText();
+	cv::Mat scratch(cv::Size theSize, int theType);
+	void allocation(const char *theSite, size_t theSize);
+	void allocation(cvui_context_t& theContext, const char *theSite, size_t theSize);
 	int iarea(int theX, int theY, int theWidth, int theHeight);
 	bool button(cvui_block_t& theBlock, int theX, int theY, int theWidth, int theHeight, const cv::String& theLabel, bool theUpdateLayout, double theFontScale, unsigned int theInsideColor);
 	bool button(cvui_block_t& theBlock, int theX, int theY, const cv::String& theLabel, double theFontScale, unsigned int theInsideColor);
@@ -1257,6 +2547,15 @@ namespace internal
 	void window(cvui_block_t& theBlock, int theX, int theY, int theWidth, int theHeight, const cv::String& theTitle, double theFontScale);
 	void rect(cvui_block_t& theBlock, int theX, int theY, int theWidth, int theHeight, unsigned int theBorderColor, unsigned int theFillingColor);
 	void sparkline(cvui_block_t& theBlock, std::vector<double>& theValues, int theX, int theY, int theWidth, int theHeight, unsigned int theColor);
+	int table(cvui_block_t& theBlock, int theX, int theY, int theWidth, int theHeight, cvui_table_t *theTable, int theRows, int theColumns, const cv::String theHeaders[], const int theColumnWidths[], cvui_table_cell_t theCell, void *theData, double theFontScale);
+	void tableCache(cvui_table_t *theTable, int theRows, int theColumns, int theCapacity);
+	void tableFormatRow(cvui_table_t *theTable, int theRow, cvui_table_cell_t theCell, void *theData);
+	void annotations(cvui_block_t& theBlock, const cvui_annotation_t *theAnnotations, size_t theCount, double theFontScale);
+	void composite(cvui_context_t& theContext, const cv::Mat& theFrame, cv::Mat& theOutput);
+
+	template<int N>
+	void compositeRows(const cv::Mat& theLayer, const uchar *theLayerRows, const cv::Mat& theFrame, cv::Mat& theOutput, int theStart, int theEnd);
+	const cv::Mat& annotationLabel(cvui_context_t& theContext, const char *theLabel, unsigned int theColor, double theFontScale, int theType);
 	bool trackbar(cvui_block_t &theBlock, int theX, int theY, int theWidth, long double *theValue, const TrackbarParams& theParams);
 	inline void trackbarForceValuesAsMultiplesOfSmallStep(const TrackbarParams & theParams, long double *theValue);
 	inline long double trackbarXPixelToValue(const TrackbarParams & theParams, cv::Rect & theBounding, int thePixelX);
@@ -1264,11 +2563,33 @@ namespace internal
 	inline long double clamp01(long double value);
 	void findMinMax(std::vector<double>& theValues, double *theMin, double *theMax);
 	cv::Scalar hexToScalar(unsigned int theColor);
+	void prepareTheme(cvui_theme_t& theTheme);
+	inline const cvui_theme_t& theme();
+	bool skin(cv::Mat& theWhere, int theSkin, int theState, const cv::Rect& theRect);
+	cvui_skin_cache_t *skinCache(cvui_skin_t& theSkin, cv::Size theSize, int theType);
+	void skinStretch(const cvui_skin_t& theSkin, cv::Size theSize, int theType, cvui_skin_cache_t& theEntry);
+	void skinBlend(cv::Mat& theWhere, const cv::Rect& theRect, const cv::Mat& theImage, const cv::Mat& theAlpha);
+	inline cv::Scalar targetColor(const cv::Mat& theWhere, const cv::Scalar& theColor);
+	bool rawPixel(const cv::Mat& theWhere, const cv::Scalar& theColor, uchar *thePixel);
+	void fillSpan(cv::Mat& theWhere, int theX1, int theY1, int theX2, int theY2, const uchar *thePixel);
+	void line(cv::Mat& theWhere, cv::Point thePoint1, cv::Point thePoint2, const cv::Scalar& theColor);
+	void rectangle(cv::Mat& theWhere, const cv::Rect& theRect, const cv::Scalar& theColor, int theThickness);
+	void putText(cv::Mat& theWhere, const cv::String& theText, cv::Point thePosition, double theFontScale, const cv::Scalar& theColor);
+	void convertImage(const cv::Mat& theImage, cv::Mat& theTarget);
 	unsigned int brightenColor(unsigned int theColor, unsigned int theDelta);
 	unsigned int darkenColor(unsigned int theColor, unsigned int theDelta);
 	uint8_t brightnessOfColor(unsigned int theColor);
 	void resetRenderingBuffer(cvui_block_t& theScreen);
 
+	template<typename T, size_t N>
+	bool ringPush(cvui_ring_t<T, N>& theRing, const T& theItem);
+
+	template<typename T, size_t N>
+	T *ringPeek(cvui_ring_t<T, N>& theRing);
+
+	template<typename T, size_t N>
+	void ringPop(cvui_ring_t<T, N>& theRing);
+
 	template <typename T> // T can be any floating point type (float, double, long double)
 	TrackbarParams makeTrackbarParams(T min, T max, int theDecimals = 1, int theSegments = 1, T theStep = -1., unsigned int theOptions = 0, const char *theFormat = "%.1Lf", double theFontScale = DEFAULT_FONT_SCALE);
 
@@ -1278,14 +2599,42 @@ namespace internal
 	template <typename T> // T can be any numeric type (int, double, unsigned int, etc)
 	bool trackbar(cv::Mat& theWhere, int theX, int theY, int theWidth, T *theValue, const TrackbarParams& theParams);
 
-	template<typename num_type>
-	TrackbarParams makeTrackbarParams(num_type theMin, num_type theMax, num_type theStep, int theSegments, const char *theLabelFormat, unsigned int theOptions, double theFontScale) {
-		TrackbarParams aParams;
+	template<typename T, size_t N>
+	bool ringPush(cvui_ring_t<T, N>& theRing, const T& theItem) {
+		size_t aTail = theRing.tail.load(std::memory_order_relaxed);
+		size_t aNext = (aTail + 1) % N;
 
-		aParams.min = (long double)theMin;
-		aParams.max = (long double)theMax;
-		aParams.step = (long double)theStep;
-		aParams.options = theOptions;
+		if (aNext == theRing.head.load(std::memory_order_acquire)) {
+			theRing.dropped.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+
+		theRing.items[aTail] = theItem;
+		theRing.tail.store(aNext, std::memory_order_release);
+
+		return true;
+	}
+
+	template<typename T, size_t N>
+	T *ringPeek(cvui_ring_t<T, N>& theRing) {
+		size_t aHead = theRing.head.load(std::memory_order_relaxed);
+		return aHead == theRing.tail.load(std::memory_order_acquire) ? nullptr : &theRing.items[aHead];
+	}
+
+	template<typename T, size_t N>
+	void ringPop(cvui_ring_t<T, N>& theRing) {
+		size_t aHead = theRing.head.load(std::memory_order_relaxed);
+		theRing.head.store((aHead + 1) % N, std::memory_order_release);
+	}
+
+	template<typename num_type>
+	TrackbarParams makeTrackbarParams(num_type theMin, num_type theMax, num_type theStep, int theSegments, const char *theLabelFormat, unsigned int theOptions, double theFontScale) {
+		TrackbarParams aParams;
+
+		aParams.min = (long double)theMin;
+		aParams.max = (long double)theMax;
+		aParams.step = (long double)theStep;
+		aParams.options = theOptions;
 		aParams.segments = theSegments;
 		aParams.labelFormat = theLabelFormat;
 		aParams.fontScale = theFontScale;
@@ -1306,10 +2655,10 @@ namespace internal
 
 	template <typename num_type>
 	bool trackbar(cv::Mat& theWhere, int theX, int theY, int theWidth, num_type *theValue, const TrackbarParams& theParams) {
-		gScreen.where = theWhere;
+		cvui_block_t& aScreen = internal::screen(theWhere);
 
 		long double aValueAsDouble = static_cast<long double>(*theValue);
-		bool aResult = internal::trackbar(gScreen, theX, theY, theWidth, &aValueAsDouble, theParams);
+		bool aResult = internal::trackbar(aScreen, theX, theY, theWidth, &aValueAsDouble, theParams);
 		*theValue = static_cast<num_type>(aValueAsDouble);
 		
 		return aResult;
@@ -1334,99 +2683,798 @@ namespace render {
 	void checkboxCheck(cvui_block_t& theBlock, cv::Rect& theShape);
 	void window(cvui_block_t& theBlock, cv::Rect& theTitleBar, cv::Rect& theContent, const cv::String& theTitle, double theFontScale);
 	void rect(cvui_block_t& theBlock, cv::Rect& thePos, unsigned int theBorderColor, unsigned int theFillingColor);
+	void rect(cvui_block_t& theBlock, cv::Rect& thePos, const cv::Scalar& theBorderColor, const cv::Scalar& theFillingColor);
 	void sparkline(cvui_block_t& theBlock, std::vector<double>& theValues, cv::Rect &theRect, double theMin, double theMax, unsigned int theColor);
+	void table(cvui_block_t& theBlock, cv::Rect& theShape, cv::Rect& theRowsArea, cvui_table_t *theTable, const cv::String theHeaders[], const int theColumnWidths[], int theHeaderHeight, int theRowHeight, double theFontScale);
+	void tableCell(cvui_block_t& theBlock, cv::Rect theCell, const cv::String& theText, int theBaseline, double theFontScale);
+	void tableScrollbar(cvui_block_t& theBlock, cv::Rect& theShape, int theScroll, int theVisibleRows, int theRows);
+	void annotations(cvui_block_t& theBlock, const cvui_annotation_t *theAnnotations, const cv::Mat *theLabels, const cv::Point *theLabelPositions, size_t theCount);
+	void annotationLabel(cv::Mat& theWhere, const cv::Mat& theLabel, cv::Point thePosition, int theStart, int theEnd);
+
+	template<int N>
+	void annotationRows(cv::Mat& theWhere, const cvui_annotation_t *theAnnotations, const cv::Mat *theLabels, const cv::Point *theLabelPositions, size_t theCount, int theStart, int theEnd);
+
+	int putText(cvui_block_t& theBlock, int theState, cv::Scalar aColor, const std::string& theText, const cv::Point & thePosition, double theFontScale);
+	int putTextCentered(cvui_block_t& theBlock, const cv::Point& position, const std::string& text, double theFontScale);
+}
+
+template <typename num_type>
+bool trackbar(cv::Mat& theWhere, int theX, int theY, int theWidth, num_type *theValue, num_type theMin, num_type theMax, int theSegments, const char *theLabelFormat, unsigned int theOptions, num_type theDiscreteStep, double theFontScale) {
+	internal::TrackbarParams aParams = internal::makeTrackbarParams(theMin, theMax, theDiscreteStep, theSegments, theLabelFormat, theOptions, theFontScale);
+	return trackbar<num_type>(theWhere, theX, theY, theWidth, theValue, aParams);
+}
+
+template <typename num_type>
+bool trackbar(int theWidth, num_type *theValue, num_type theMin, num_type theMax, int theSegments, const char *theLabelFormat, unsigned int theOptions, num_type theDiscreteStep, double theFontScale) {
+	internal::TrackbarParams aParams = internal::makeTrackbarParams(theMin, theMax, theDiscreteStep, theSegments, theLabelFormat, theOptions, theFontScale);
+	return trackbar<num_type>(theWidth, theValue, aParams);
+}
+
+} // namespace cvui
+
+#endif // _CVUI_H_
+
+// Below this line is the implementation of all functions declared above.
+
+// If cvui is used as a precompiled library (e.g. the CMake target cvui), the implementation
+// lives in the library, so it is not compiled again even if CVUI_IMPLEMENTATION is defined.
+#if defined(CVUI_PRECOMPILED) && defined(CVUI_IMPLEMENTATION)
+	#undef CVUI_IMPLEMENTATION
+#endif
+
+#if !defined(CVUI_IMPLEMENTATION) && !defined(CVUI_PRECOMPILED) && !defined(CVUI_DISABLE_COMPILATION_NOTICES)
+	// cvui.h is being included without CVUI_IMEPLEMENTATION. Let's output a compile notice about it
+	// to help those trying to debug possible cvui compilation errors.
+	#pragma _CVUI_COMPILE_MESSAGE(_CVUI_NO_IMPLEMENTATION_NOTICE)
+#endif
+
+#ifdef CVUI_IMPLEMENTATION
+
+// Show some helping hand in case cvui.h does not compile because of inclusion in multiple files.
+#ifndef CVUI_DISABLE_COMPILATION_NOTICES
+	#pragma _CVUI_COMPILE_MESSAGE(_CVUI_IMPLEMENTATION_NOTICE)
+#endif
+
+#include <algorithm>
+#include <map>
+#include <tuple>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <stdarg.h>
+#include <string.h>
+
+// Universal intrinsics of OpenCV, used to blend the UI layer over frames (see internal::compositeRows()).
+#if (CV_MAJOR_VERSION > 3) || (CV_MAJOR_VERSION == 3 && CV_MINOR_VERSION >= 4)
+#include <opencv2/core/hal/intrin.hpp>
+#endif
+
+namespace cvui
+{
+double DEFAULT_FONT_SCALE = 0.4;
+unsigned int DEFAULT_BUTTON_COLOR = 0x424242;
+unsigned int DEFAULT_TEXT_COLOR = 0xCECECE;
+
+// This is an internal namespace with all code
+// that is shared among components/functions
+namespace internal
+{
+	// All state related to a frame lives in the contexts, and each thread has its own
+	// current context and formatting buffer, so the UI of each window can be built
+	// by a different thread at the same time.
+	static std::atomic<cvui_context_t*> gDefaultContext(nullptr); // set by init(), read by the presenter thread.
+	static thread_local cvui_context_t *gCurrentContext = nullptr;
+	static std::map<cv::String, cvui_context_t> gContexts; // indexed by the window name. Nodes are never erased, so pointers to contexts remain valid.
+	static std::mutex gContextsMutex; // protects gContexts, which is accessed when windows are referred to by name.
+	static thread_local char gBuffer[1024];
+	static thread_local std::string gText; // text formatted into gBuffer, see bufferText(). Keeps its storage among calls.
+	static thread_local cv::Mat gScratch; // storage of temporary images, e.g. overlays, see scratch().
+	static thread_local cvui_label_t gLabel; // label parsed by createLabel(). Keeps its storage among calls.
+	static thread_local std::vector<cvui_annotation_t> gAnnotations; // annotations informed as separate arrays, see cvui::annotations().
+	static thread_local std::vector<cv::Mat> gAnnotationLabels; // rendered label of each annotation being drawn.
+	static thread_local std::vector<cv::Point> gAnnotationLabelPositions; // where each label is drawn.
+	static cvui_allocation_hook_t gAllocationHook = nullptr;
+	static void *gAllocationHookData = nullptr;
+	static std::atomic<int> gErrorPolicy(ERROR_EXIT);
+	static cvui_error_callback_t gErrorCallback = nullptr;
+	static void *gErrorCallbackData = nullptr;
+	static std::atomic<unsigned int> gErrorsLogged(0); // bitset of the error codes already printed by ERROR_RECOVER.
+	static int gDelayWaitKey;
+	static const int gWaitSlice = 10; // milliseconds cvui::wait() spends in each cv::waitKey() call.
+	static std::thread gPresenterThread;
+	static std::atomic<bool> gPresenterRunning(false);
+	static std::mutex gPresenterMutex; // protects gPresented.
+	static std::vector<cvui_context_t *> gPresented; // windows shown by the presenter thread.
+	static cvui_skin_t gSkins[SKIN_TYPES][3]; // skins of each component, for the states OUT, OVER and DOWN.
+	static std::mutex gSkinsMutex; // protects gSkins, whose caches are changed by any thread rendering a skin.
+	static const cvui_theme_t gDefaultTheme; // prepared by its constructor.
+	static std::atomic<const cvui_theme_t *> gTheme(nullptr); // theme in use, see cvui::theme(). If nullptr, gDefaultTheme is used.
+	static std::atomic<unsigned int> gSkinFrame(0); // frames finished by all windows, used to age stretched skins.
+	static std::atomic<bool> gSkinned(false); // if any skin is set, so components without skins do not lock gSkinsMutex.
+
+	bool isMouseButton(cvui_mouse_btn_t& theButton, int theQuery) {
+		bool aRet = false;
+
+		switch (theQuery) {
+			case cvui::CLICK:
+			case cvui::UP:
+				aRet = theButton.justReleased; break;
+			case cvui::DOWN:
+				aRet = theButton.justPressed; break;
+			case cvui::IS_DOWN:
+				aRet = theButton.pressed; break;
+		}
+
+		return aRet;
+	}
+
+	cvui_mouse_btn_t& mouseButton(cvui_context_t& theContext, int theButton) {
+		if (theButton != RIGHT_BUTTON && theButton != MIDDLE_BUTTON && theButton != LEFT_BUTTON) {
+			internal::error(6, "Invalid mouse button. Are you using one of the available: cvui::{RIGHT,MIDDLE,LEFT}_BUTTON ?");
+			return theContext.mouse.buttons[LEFT_BUTTON];
+		}
+
+		return theContext.mouse.buttons[theButton];
+	}
+
+	void resetMouseButton(cvui_mouse_btn_t& theButton) {
+		theButton.justPressed = false;
+		theButton.justReleased = false;
+		theButton.pressed = false;
+	}
+
+	cvui_context_t& input(cvui_context_t& theContext) {
+		if (theContext.inputPolled) {
+			return theContext;
+		}
+
+		// Apply the mouse events in the order they were received. A frame can only
+		// see one state change per button (e.g. justPressed), so the event that would
+		// change a button again is left in the ring for the next frame. That way
+		// a press and a release arriving between two frames are seen as a click
+		// in two frames instead of vanishing.
+		unsigned int aChanged = 0;
+		cvui_mouse_event_t *aEvent;
+
+		if (!theContext.mouseSamples.empty()) {
+			theContext.carriedSample = theContext.mouseSamples.back();
+			theContext.carriedSample.carried = true;
+			theContext.hasCarriedSample = true;
+		}
+
+		theContext.mouseSamples.clear();
+		theContext.keys.clear();
+
+		if (theContext.replayNext < theContext.replay.size()) {
+			internal::replayInput(theContext);
+			theContext.inputPolled = true;
+			return theContext;
+		}
+
+		while ((aEvent = internal::ringPeek(theContext.mouseEvents)) != nullptr) {
+			bool aDown;
+			int aButton = internal::mouseEventButton(aEvent->type, &aDown);
+
+			if (aButton != -1) {
+				if (internal::bitsetHas(aChanged, 1 << aButton)) {
+					break;
+				}
+				aChanged |= 1 << aButton;
+			}
+
+			internal::useMouseEvent(theContext, *aEvent);
+			internal::ringPop(theContext.mouseEvents);
+		}
+
+		// Hand out the keys in the order they were pressed. A key pressed more than
+		// once waits for the next frame, so each press can activate a shortcut.
+		cvui_key_event_t *aKey;
+
+		while ((aKey = internal::ringPeek(theContext.keyEvents)) != nullptr) {
+			bool aRepeated = false;
+
+			for (size_t i = 0; i < theContext.keys.size() && !aRepeated; i++) {
+				aRepeated = theContext.keys[i].code == aKey->code;
+			}
+
+			if (aRepeated) {
+				break;
+			}
+
+			internal::useKey(theContext, *aKey);
+			internal::ringPop(theContext.keyEvents);
+		}
+
+		theContext.inputPolled = true;
+		return theContext;
+	}
+
+	void useMouseEvent(cvui_context_t& theContext, const cvui_mouse_event_t& theEvent) {
+		internal::applyMouseEvent(theContext.mouse, theEvent);
+
+		if (theEvent.type != EVENT_MOUSEWHEEL) {
+			cvui_mouse_sample_t aSample;
+
+			aSample.position = theEvent.position;
+			aSample.pressed = theContext.mouse.anyButton.pressed;
+			aSample.carried = false;
+			aSample.timestamp = theEvent.timestamp;
+
+			// The first motion of a frame continues from where the previous one ended.
+			bool aCarry = theContext.mouseSamples.empty() && theContext.hasCarriedSample;
+
+			if (theContext.mouseSamples.size() + (aCarry ? 1 : 0) >= theContext.mouseSamples.capacity()) {
+				internal::allocation(theContext, "mouseSamples", (theContext.mouseSamples.capacity() + 2) * sizeof(cvui_mouse_sample_t));
+			}
+			if (aCarry) {
+				theContext.mouseSamples.push_back(theContext.carriedSample);
+			}
+			theContext.mouseSamples.push_back(aSample);
+		}
+
+		if (theContext.recording != nullptr) {
+			cvui_input_record_t aRecord;
+
+			aRecord.frame = theContext.frame - theContext.recordingStart;
+			aRecord.kind = 0;
+			aRecord.type = (int16_t)theEvent.type;
+			aRecord.x = theEvent.position.x;
+			aRecord.y = theEvent.position.y;
+			aRecord.value = theEvent.wheel;
+			fwrite(&aRecord, sizeof(aRecord), 1, theContext.recording);
+		}
+	}
+
+	void useKey(cvui_context_t& theContext, const cvui_key_event_t& theKey) {
+		if (theContext.keys.size() == theContext.keys.capacity()) {
+			internal::allocation(theContext, "keys", (theContext.keys.capacity() + 1) * sizeof(cvui_key_event_t));
+		}
+		theContext.keys.push_back(theKey);
+
+		if (theContext.recording != nullptr) {
+			cvui_input_record_t aRecord;
+
+			aRecord.frame = theContext.frame - theContext.recordingStart;
+			aRecord.kind = 1;
+			aRecord.type = 0;
+			aRecord.x = 0;
+			aRecord.y = 0;
+			aRecord.value = theKey.code;
+			fwrite(&aRecord, sizeof(aRecord), 1, theContext.recording);
+		}
+	}
+
+	void swapRecord(cvui_input_record_t& theRecord) {
+		uint32_t aFrame = theRecord.frame;
+		uint16_t aKind = (uint16_t)theRecord.kind, aType = (uint16_t)theRecord.type;
+		uint32_t aX = (uint32_t)theRecord.x, aY = (uint32_t)theRecord.y, aValue = (uint32_t)theRecord.value;
+
+		theRecord.frame = (aFrame >> 24) | ((aFrame >> 8) & 0xff00) | ((aFrame << 8) & 0xff0000) | (aFrame << 24);
+		theRecord.kind = (int16_t)(uint16_t)((aKind >> 8) | (aKind << 8));
+		theRecord.type = (int16_t)(uint16_t)((aType >> 8) | (aType << 8));
+		theRecord.x = (int32_t)((aX >> 24) | ((aX >> 8) & 0xff00) | ((aX << 8) & 0xff0000) | (aX << 24));
+		theRecord.y = (int32_t)((aY >> 24) | ((aY >> 8) & 0xff00) | ((aY << 8) & 0xff0000) | (aY << 24));
+		theRecord.value = (int32_t)((aValue >> 24) | ((aValue >> 8) & 0xff00) | ((aValue << 8) & 0xff0000) | (aValue << 24));
+	}
+
+	void replayInput(cvui_context_t& theContext) {
+		unsigned int aFrame = theContext.frame - theContext.replayStart;
+		int64 aNow = cv::getTickCount();
+
+		// Input from the window system would make the replay diverge from the recording.
+		while (internal::ringPeek(theContext.mouseEvents) != nullptr) {
+			internal::ringPop(theContext.mouseEvents);
+		}
+		while (internal::ringPeek(theContext.keyEvents) != nullptr) {
+			internal::ringPop(theContext.keyEvents);
+		}
+
+		while (theContext.replayNext < theContext.replay.size() && theContext.replay[theContext.replayNext].frame <= aFrame) {
+			const cvui_input_record_t& aRecord = theContext.replay[theContext.replayNext++];
+
+			if (aRecord.kind == 0) {
+				cvui_mouse_event_t aEvent;
+
+				aEvent.type = aRecord.type;
+				aEvent.position = cv::Point(aRecord.x, aRecord.y);
+				aEvent.wheel = aRecord.value;
+				aEvent.timestamp = aNow;
+				internal::useMouseEvent(theContext, aEvent);
+
+			} else {
+				internal::useKey(theContext, internal::keyEvent(aRecord.value, aNow));
+			}
+		}
+	}
+
+	void queueKey(cvui_context_t& theContext, int theKey) {
+		cvui_context_t *aTarget = &theContext;
+		int64 aMostRecent = 0;
+
+		// OpenCV does not tell which window received the key, so we assume it
+		// was the one with the most recent mouse activity.
+		{
+			std::lock_guard<std::mutex> aLock(internal::gContextsMutex);
+
+			for (auto& aEntry : internal::gContexts) {
+				int64 aActivity = aEntry.second.mouseActivity.load(std::memory_order_relaxed);
+
+				if (aActivity > aMostRecent) {
+					aMostRecent = aActivity;
+					aTarget = &aEntry.second;
+				}
+			}
+		}
+
+		internal::ringPush(aTarget->keyEvents, internal::keyEvent(theKey, cv::getTickCount()));
+	}
+
+	cvui_key_event_t keyEvent(int theCode, int64 theTimestamp) {
+		cvui_key_event_t aEvent;
+
+		aEvent.key = theCode & 0xff;
+		aEvent.code = theCode;
+		aEvent.modifiers = 0;
+		aEvent.timestamp = theTimestamp;
+		aEvent.consumed = false;
+
+		// GTK reports the key in the lower 16 bits and the state of the modifiers (shift 1,
+		// lock 2, control 4, alt 8, ...) in the upper ones. Other backends only use the upper
+		// bits for special keys, e.g. virtual key codes on Windows, whose lower bits are zero.
+		if ((theCode & 0xffff) != 0 && theCode > 0xffff) {
+			int aState = theCode >> 16;
+			aEvent.modifiers = ((aState & 1) ? KEY_SHIFT : 0) | ((aState & 4) ? KEY_CTRL : 0) | ((aState & 8) ? KEY_ALT : 0);
+		}
+
+		return aEvent;
+	}
+
+	int waitKey(int theDelay) {
+#if defined(CVUI_HEADLESS)
+		// There are no windows, so no events to wait for.
+		std::this_thread::sleep_for(std::chrono::milliseconds(theDelay > 0 ? theDelay : 1));
+		return -1;
+#elif (CV_MAJOR_VERSION > 3) || (CV_MAJOR_VERSION == 3 && CV_MINOR_VERSION >= 2)
+		return cv::waitKeyEx(theDelay);
+#else
+		return cv::waitKey(theDelay);
+#endif
+	}
+
+	void resetInput(cvui_context_t& theContext) {
+		theContext.mouse.anyButton.justReleased = false;
+		theContext.mouse.anyButton.justPressed = false;
+		theContext.mouse.wheel = 0;
+
+		for (int i = cvui::LEFT_BUTTON; i <= cvui::RIGHT_BUTTON; i++) {
+			theContext.mouse.buttons[i].justReleased = false;
+			theContext.mouse.buttons[i].justPressed = false;
+		}
+
+		// Input received so far (e.g. during a cv::waitKey() call) is
+		// taken when the next frame first uses it.
+		theContext.inputPolled = false;
+	}
+
+	bool hasPendingInput(cvui_context_t& theContext) {
+		return theContext.mouseEvents.head.load(std::memory_order_relaxed) != theContext.mouseEvents.tail.load(std::memory_order_acquire) ||
+			   theContext.keyEvents.head.load(std::memory_order_relaxed) != theContext.keyEvents.tail.load(std::memory_order_acquire);
+	}
+
+	void presenterLoop(int theDelayWaitKey) {
+		std::vector<cvui_context_t *> aContexts;
+
+		while (gPresenterRunning.load()) {
+			{
+				std::lock_guard<std::mutex> aLock(gPresenterMutex);
+				aContexts = gPresented;
+			}
+
+			for (auto aContext : aContexts) {
+				cvui_triple_buffer_t& aFrames = aContext->frames;
+
+#ifndef CVUI_HEADLESS
+				if (!aContext->windowReady && !aContext->offscreen) {
+					cv::namedWindow(aContext->windowName);
+					cv::setMouseCallback(aContext->windowName, handleMouse, aContext);
+					aContext->windowReady = true;
+				}
+#endif
+
+				// Only take the middle buffer if it holds a frame that was not shown yet.
+				if (aFrames.middle.load(std::memory_order_acquire) & cvui_triple_buffer_t::FRESH) {
+					aFrames.front = aFrames.middle.exchange(aFrames.front, std::memory_order_acq_rel) & ~cvui_triple_buffer_t::FRESH;
+#ifndef CVUI_HEADLESS
+					if (aContext->windowReady) {
+						cv::imshow(aContext->windowName, aFrames.buffers[aFrames.front]);
+					}
+#endif
+				}
+			}
+
+			// Mouse callbacks run within cv::waitKey(), i.e. in this thread,
+			// and only push events into the queues of the windows.
+			int aKey = internal::waitKey(theDelayWaitKey);
+
+			cvui_context_t *aDefault = gDefaultContext.load();
+
+			if (aKey != -1 && aDefault != nullptr) {
+				internal::queueKey(*aDefault, aKey);
+			}
+		}
+	}
+
+	cvui_context_t *createContext(const cv::String& theName, bool theOffscreen) {
+		std::lock_guard<std::mutex> aLock(internal::gContextsMutex);
+
+		// Contexts hold the (non-copyable) event queues, so they are set up in place.
+		cvui_context_t *aHandle = &internal::gContexts[theName];
+		cvui_context_t& aContex = *aHandle;
+
+		aContex.windowName = theName;
+		aContex.mouse.position.x = 0;
+		aContex.mouse.position.y = 0;
+		aContex.mouse.wheel = 0;
+		aContex.hasCarriedSample = false;
+		// Windows watched again start over, so their stores are emptied along with their counts.
+		aContex.widgets.slots.clear();
+		aContex.widgets.count = 0;
+		aContex.labels.slots.clear();
+		aContex.labels.count = 0;
+		aContex.nextId = 0;
+		aContex.lastId = 0;
+		aContex.frame = 0;
+		aContex.offscreen = theOffscreen;
+
+		internal::resetMouseButton(aContex.mouse.anyButton);
+		internal::resetMouseButton(aContex.mouse.buttons[RIGHT_BUTTON]);
+		internal::resetMouseButton(aContex.mouse.buttons[MIDDLE_BUTTON]);
+		internal::resetMouseButton(aContex.mouse.buttons[LEFT_BUTTON]);
+
+		return aHandle;
+	}
+
+	void profileZone(int theCategory, int64 theStart, int64 theNested) {
+		cvui_context_t& aContext = internal::getContext();
+		cvui_profile_widget_t aWidget;
+
+		int64 aEnd = cv::getTickCount();
+
+		// The trace keeps the whole zone, whose nested zones are shown inside it by trace viewers.
+		aWidget.id = aContext.lastId;
+		aWidget.category = theCategory;
+		aWidget.time = (aEnd - theStart - theNested) * 1000.0 / cv::getTickFrequency();
+
+		if (!aContext.trace.empty()) {
+			internal::traceZone(aContext, aContext.frame, gProfileCategories[theCategory], aWidget.id, theStart, aEnd);
+		}
+
+		aContext.profile.time[theCategory] += aWidget.time;
+		aContext.profile.calls[theCategory]++;
+
+		if (aContext.profile.widgets.size() == aContext.profile.widgets.capacity()) {
+			internal::allocation(aContext, "profile", (aContext.profile.widgets.capacity() + 1) * sizeof(cvui_profile_widget_t));
+		}
+		aContext.profile.widgets.push_back(aWidget);
+	}
+
+	void profileCount(int theCounter) {
+		internal::getContext().profile.counters[theCounter]++;
+	}
+
+	void profileFrame(cvui_context_t& theContext) {
+#ifdef CVUI_PROFILER
+		int64 aNow = cv::getTickCount();
+		cvui_profile_t& aLast = theContext.lastProfile;
+		cvui_profile_t& aCurrent = theContext.profile;
+
+		aCurrent.frameTime = theContext.profileStart == 0 ? 0 : (aNow - theContext.profileStart) * 1000.0 / cv::getTickFrequency();
+
+		if (!theContext.trace.empty() && theContext.profileStart != 0) {
+			internal::traceZone(theContext, theContext.frame, "frame", 0, theContext.profileStart, aNow);
+		}
+		theContext.profileStart = aNow;
+
+		// The current frame becomes the last one. Vectors are swapped, so their
+		// storage is reused by the next frames instead of being allocated again.
+		std::swap(aCurrent, aLast);
+		aCurrent.history.swap(aLast.history);
+		std::swap(aCurrent.historyNext, aLast.historyNext);
+
+		// Once the history is full, the new frame replaces the oldest one.
+		if (aLast.history.size() < gProfileHistory) {
+			if (aLast.history.size() == aLast.history.capacity()) {
+				internal::allocation(theContext, "profile", (aLast.history.capacity() + 1) * sizeof(double));
+			}
+			aLast.history.push_back(aLast.frameTime);
+		} else {
+			aLast.history[aLast.historyNext] = aLast.frameTime;
+		}
+		aLast.historyNext = (aLast.historyNext + 1) % gProfileHistory;
+
+		aCurrent.frameTime = 0;
+		aCurrent.widgets.clear();
+		std::fill(aCurrent.time, aCurrent.time + PROFILE_CATEGORIES, 0.0);
+		std::fill(aCurrent.calls, aCurrent.calls + PROFILE_CATEGORIES, 0u);
+		std::fill(aCurrent.counters, aCurrent.counters + PROFILE_COUNTERS, 0u);
+#else
+		(void)theContext;
+#endif
+	}
+
+	void traceZone(cvui_context_t& theContext, unsigned int theFrame, const char *theName, unsigned int theId, int64 theStart, int64 theEnd) {
+		cvui_trace_frame_t& aFrame = theContext.trace[theFrame % theContext.trace.size()];
+		cvui_trace_event_t aEvent;
+
+		// The slot still has the zones of an old frame, which are discarded.
+		// The storage of the vector is kept, so it is not allocated again.
+		if (aFrame.frame != theFrame) {
+			aFrame.frame = theFrame;
+			aFrame.events.clear();
+		}
+
+		aEvent.name = theName;
+		aEvent.id = theId;
+		aEvent.start = theStart;
+		aEvent.end = theEnd;
+
+		if (aFrame.events.size() == aFrame.events.capacity()) {
+			internal::allocation(theContext, "trace", (aFrame.events.capacity() + 1) * sizeof(cvui_trace_event_t));
+		}
+		aFrame.events.push_back(aEvent);
+	}
+
+	void writeJsonString(FILE *theFile, const char *theText) {
+		fputc('"', theFile);
+
+		for (const char *c = theText; *c != 0; c++) {
+			if (*c == '"' || *c == '\\') {
+				fputc('\\', theFile);
+				fputc(*c, theFile);
+			} else if ((unsigned char)*c < 0x20) {
+				fprintf(theFile, "\\u%04x", (unsigned char)*c);
+			} else {
+				fputc(*c, theFile);
+			}
+		}
+
+		fputc('"', theFile);
+	}
+
+	bool consumeShortcut(cvui_context_t& theContext, const cv::String& theLabel) {
+		cvui_key_event_t *aKey = nullptr;
+
+		for (size_t i = 0; i < theContext.keys.size() && aKey == nullptr; i++) {
+			aKey = theContext.keys[i].consumed ? nullptr : &theContext.keys[i];
+		}
+
+		if (aKey == nullptr) {
+			return false;
+		}
+
+		// TODO: replace with something like strpos(). I think it has better performance.
+		const cvui_label_t& aLabel = internal::createLabel(theLabel);
+
+		if (!aLabel.hasShortcut) {
+			return false;
+		}
+
+		for (size_t i = 0; i < theContext.keys.size(); i++) {
+			cvui_key_event_t& aEvent = theContext.keys[i];
+
+			// Special keys (e.g. arrows on GTK, 0xff51) share the lowest 8 bits with characters.
+			if (!aEvent.consumed && (aEvent.code & 0xff00) == 0 && tolower(aLabel.shortcut) == tolower((char)aEvent.key)) {
+				aEvent.consumed = true;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void applyMouseEvent(cvui_mouse_t& theMouse, const cvui_mouse_event_t& theEvent) {
+		bool aDown;
+		int aButton = internal::mouseEventButton(theEvent.type, &aDown);
+
+		if (aButton != -1) {
+			cvui_mouse_btn_t& aBtn = theMouse.buttons[aButton];
+
+			aBtn.justPressed = aBtn.justPressed || aDown;
+			aBtn.justReleased = aBtn.justReleased || !aDown;
+			aBtn.pressed = aDown;
+
+			theMouse.anyButton.justPressed = theMouse.anyButton.justPressed || aDown;
+			theMouse.anyButton.justReleased = theMouse.anyButton.justReleased || !aDown;
+			theMouse.anyButton.pressed = theMouse.buttons[LEFT_BUTTON].pressed || theMouse.buttons[MIDDLE_BUTTON].pressed || theMouse.buttons[RIGHT_BUTTON].pressed;
+		}
+
+		if (theEvent.type == EVENT_MOUSEWHEEL) {
+			// Some platforms report wheel events using screen coordinates,
+			// so they must not change the position of the mouse cursor.
+			theMouse.wheel += theEvent.wheel;
+		} else {
+			theMouse.position = theEvent.position;
+		}
+	}
+
+	int mouseEventButton(int theType, bool *theDown) {
+		switch (theType) {
+			case EVENT_LBUTTONDOWN: *theDown = true; return LEFT_BUTTON;
+			case EVENT_MBUTTONDOWN: *theDown = true; return MIDDLE_BUTTON;
+			case EVENT_RBUTTONDOWN: *theDown = true; return RIGHT_BUTTON;
+			case EVENT_LBUTTONUP: *theDown = false; return LEFT_BUTTON;
+			case EVENT_MBUTTONUP: *theDown = false; return MIDDLE_BUTTON;
+			case EVENT_RBUTTONUP: *theDown = false; return RIGHT_BUTTON;
+			default: *theDown = false; return -1;
+		}
+	}
+
+	void init(const cv::String& theWindowName, int theDelayWaitKey) {
+		std::lock_guard<std::mutex> aLock(internal::gContextsMutex);
+
+		internal::gCurrentContext = &internal::gContexts[theWindowName];
+		internal::gDefaultContext.store(internal::gCurrentContext);
+		internal::gDelayWaitKey = theDelayWaitKey;
+	}
+
+	cvui_context_t& getContext() {
+		if (internal::gCurrentContext != nullptr) {
+			// Return currently active context.
+			return *internal::gCurrentContext;
+
+		} else if (cvui_context_t *aDefault = internal::gDefaultContext.load()) {
+			// We have no active context, so let's use the default one.
+			return *aDefault;
+
+		} else {
+			// Apparently we have no window at all, probably cvui::init() was never called.
+			// Components can still be rendered, they will just not receive any input, so
+			// this is no longer an error (it used to be error 5, which is not used anymore).
+			static thread_local cvui_context_t aDetached;
+			return aDetached;
+		}
+	}
+
+	cvui_context_t& getContext(const cv::String& theWindowName) {
+		// Lookups by name are only performed at the API boundary, e.g. cvui::update(NAME).
+		// Components always use the current context, which is available as a pointer.
+		if (theWindowName.empty()) {
+			return internal::getContext();
+		}
+
+		cvui_context_t *aContext;
+		bool aCreated = false;
+
+		{
+			std::lock_guard<std::mutex> aLock(internal::gContextsMutex);
+			auto aEntry = internal::gContexts.find(theWindowName);
+
+			if (aEntry == internal::gContexts.end()) {
+				aEntry = internal::gContexts.emplace(std::piecewise_construct, std::forward_as_tuple(theWindowName), std::forward_as_tuple()).first;
+				aCreated = true;
+			}
 
-	int putText(cvui_block_t& theBlock, int theState, cv::Scalar aColor, const std::string& theText, const cv::Point & thePosition, double theFontScale);
-	int putTextCentered(cvui_block_t& theBlock, const cv::Point& position, const std::string& text, double theFontScale);
-}
+			aContext = &aEntry->second;
+		}
 
-template <typename num_type>
-bool trackbar(cv::Mat& theWhere, int theX, int theY, int theWidth, num_type *theValue, num_type theMin, num_type theMax, int theSegments, const char *theLabelFormat, unsigned int theOptions, num_type theDiscreteStep, double theFontScale) {
-	internal::TrackbarParams aParams = internal::makeTrackbarParams(theMin, theMax, theDiscreteStep, theSegments, theLabelFormat, theOptions, theFontScale);
-	return trackbar<num_type>(theWhere, theX, theY, theWidth, theValue, aParams);
-}
+		// Reported once the lock is released, so an error callback can use cvui.
+		if (aCreated) {
+			internal::allocation("contexts", sizeof(cvui_context_t));
+		}
 
-template <typename num_type>
-bool trackbar(int theWidth, num_type *theValue, num_type theMin, num_type theMax, int theSegments, const char *theLabelFormat, unsigned int theOptions, num_type theDiscreteStep, double theFontScale) {
-	internal::TrackbarParams aParams = internal::makeTrackbarParams(theMin, theMax, theDiscreteStep, theSegments, theLabelFormat, theOptions, theFontScale);
-	return trackbar<num_type>(theWidth, theValue, aParams);
-}
+		return *aContext;
+	}
 
-} // namespace cvui
+	cvui_block_t& screen(cv::Mat& theWhere) {
+		cvui_block_t& aScreen = internal::getContext().screen;
+		aScreen.where = theWhere;
 
-#endif // _CVUI_H_
+		return aScreen;
+	}
 
-// Below this line is the implementation of all functions declared above.
+	// FNV-1a hash, used to create widget ids.
+	unsigned int hash(const void *theData, size_t theSize, unsigned int theSeed) {
+		const unsigned char *aBytes = (const unsigned char *)theData;
+		unsigned int aHash = theSeed;
 
-#if !defined(CVUI_IMPLEMENTATION) && !defined(CVUI_DISABLE_COMPILATION_NOTICES)
-	// cvui.h is being included without CVUI_IMEPLEMENTATION. Let's output a compile notice about it
-	// to help those trying to debug possible cvui compilation errors.
-	#pragma _CVUI_COMPILE_MESSAGE(_CVUI_NO_IMPLEMENTATION_NOTICE)
-#endif
+		for (size_t i = 0; i < theSize; i++) {
+			aHash ^= aBytes[i];
+			aHash *= 16777619u;
+		}
 
-#ifdef CVUI_IMPLEMENTATION
+		return aHash;
+	}
 
-// Show some helping hand in case cvui.h does not compile because of inclusion in multiple files.
-#ifndef CVUI_DISABLE_COMPILATION_NOTICES
-	#pragma _CVUI_COMPILE_MESSAGE(_CVUI_IMPLEMENTATION_NOTICE)
-#endif
+	unsigned int widgetId(const char *theLabel, int theX, int theY) {
+		cvui_context_t& aContext = internal::getContext();
+		unsigned int aId;
 
-namespace cvui
-{
-double DEFAULT_FONT_SCALE = 0.4;
-unsigned int DEFAULT_BUTTON_COLOR = 0x424242;
+		if (aContext.nextId != 0) {
+			// An explicit id was informed using cvui::id().
+			aId = aContext.nextId;
+			aContext.nextId = 0;
 
-// This is an internal namespace with all code
-// that is shared among components/functions
-namespace internal
-{
-	bool isMouseButton(cvui_mouse_btn_t& theButton, int theQuery) {
-		bool aRet = false;
+		} else {
+			// Fallback to a hash of the position and the label of the widget.
+			int aPosition[2] = { theX, theY };
+			aId = internal::hash(aPosition, sizeof(aPosition), aContext.idScopes.empty() ? gHashSeed : aContext.idScopes.back());
 
-		switch (theQuery) {
-			case cvui::CLICK:
-			case cvui::UP:
-				aRet = theButton.justReleased; break;
-			case cvui::DOWN:
-				aRet = theButton.justPressed; break;
-			case cvui::IS_DOWN:
-				aRet = theButton.pressed; break;
+			if (theLabel != nullptr) {
+				aId = internal::hash(theLabel, strlen(theLabel), aId);
+			}
 		}
 
-		return aRet;
+		// Zero is reserved for empty slots of the widget store.
+		aContext.lastId = aId == 0 ? 1 : aId;
+		return aContext.lastId;
 	}
 
-	void resetMouseButton(cvui_mouse_btn_t& theButton) {
-		theButton.justPressed = false;
-		theButton.justReleased = false;
-		theButton.pressed = false;
+	cvui_widget_t& widget(cvui_context_t& theContext, unsigned int theId) {
+		return internal::widget(theContext.widgets, theId, theContext.frame);
 	}
 
-	void init(const cv::String& theWindowName, int theDelayWaitKey) {
-		internal::gDefaultContext = theWindowName;
-		internal::gCurrentContext = theWindowName;
-		internal::gDelayWaitKey = theDelayWaitKey;
-		internal::gLastKeyPressed = -1;
-	}
+	cvui_widget_t& widget(cvui_widget_store_t& theStore, unsigned int theId, unsigned int theFrame) {
+		cvui_widget_store_t& aStore = theStore;
 
-	cvui_context_t& getContext(const cv::String& theWindowName) {
-		if (!theWindowName.empty()) {
-			// Get context in particular
-			return internal::gContexts[theWindowName];
+		// Keep the load factor of the store below 0.7
+		if ((aStore.count + 1) * 10 > aStore.slots.size() * 7) {
+			internal::rehashWidgets(aStore, theFrame);
+		}
 
-		} else if (!internal::gCurrentContext.empty()) {
-			// No window provided, return currently active context.
-			return internal::gContexts[internal::gCurrentContext];
+		size_t aMask = aStore.slots.size() - 1;
+		size_t i = theId & aMask;
 
-		} else if (!internal::gDefaultContext.empty()) {
-			// We have no active context, so let's use the default one.
-			return internal::gContexts[internal::gDefaultContext];
+		while (aStore.slots[i].id != 0 && aStore.slots[i].id != theId) {
+			i = (i + 1) & aMask;
+		}
+
+		cvui_widget_t& aWidget = aStore.slots[i];
 
+		if (aWidget.id == 0) {
+			aWidget = cvui_widget_t();
+			aWidget.id = theId;
+			aStore.count++;
 		} else {
-			// Apparently we have no window at all! <o>
-			// This should not happen. Probably cvui::init() was never called.
-			internal::error(5, "Unable to read context. Did you forget to call cvui::init()?");
-			return internal::gContexts["first"]; // return to make the compiler happy.
+			CVUI_PROFILE_COUNT(PROFILE_CACHE_HITS);
+		}
+
+		aWidget.frame = theFrame;
+		return aWidget;
+	}
+
+	void rehashWidgets(cvui_widget_store_t& theStore, unsigned int theFrame) {
+		std::vector<cvui_widget_t> aOld;
+		size_t aAlive = 0, aCapacity = 16;
+
+		aOld.swap(theStore.slots);
+
+		// States that were not used for a while are discarded instead of being re-inserted.
+		for (size_t i = 0; i < aOld.size(); i++) {
+			if (aOld[i].id != 0 && theFrame - aOld[i].frame <= gWidgetLifetime) {
+				aAlive++;
+			}
+		}
+
+		// Leave the store half empty, so it does not need to be rehashed again soon.
+		while (aCapacity < (aAlive + 1) * 2) {
+			aCapacity *= 2;
+		}
+
+		internal::allocation("widgets", aCapacity * sizeof(cvui_widget_t));
+		theStore.slots.resize(aCapacity);
+		theStore.count = 0;
+
+		for (size_t i = 0; i < aOld.size(); i++) {
+			if (aOld[i].id != 0 && theFrame - aOld[i].frame <= gWidgetLifetime) {
+				size_t j = aOld[i].id & (aCapacity - 1);
+
+				while (theStore.slots[j].id != 0) {
+					j = (j + 1) & (aCapacity - 1);
+				}
+
+				theStore.slots[j] = std::move(aOld[i]);
+				theStore.count++;
+			}
 		}
 	}
 
@@ -1434,9 +3482,42 @@ namespace internal
 		return (theBitset & theValue) != 0;
 	}
 
-	void error(int theId, std::string theMessage) {
+	void error(int theId, const char *theMessage) {
+		internal::error(internal::getContext(), theId, theMessage);
+	}
+
+	void error(cvui_context_t& theContext, int theId, const char *theMessage) {
+		theContext.errors++;
+		internal::raise(theId, theMessage);
+	}
+
+	// Report an error according to the error policy, without counting it in any context.
+	void raise(int theId, const char *theMessage) {
+		switch (gErrorPolicy.load(std::memory_order_relaxed)) {
+			case ERROR_EXCEPTION:
+				throw cvui_exception_t(theId, theMessage);
+
+			case ERROR_CALLBACK:
+				if (gErrorCallback != nullptr) {
+					gErrorCallback(theId, theMessage, gErrorCallbackData);
+				}
+				return;
+
+			case ERROR_RECOVER:
+				// Errors tend to repeat every frame, so each one is printed only once.
+				if ((gErrorsLogged.fetch_or(1u << (theId & 31)) & (1u << (theId & 31))) == 0) {
+					std::cout << "[CVUI] Error (code " << theId << "): " << theMessage << " Further errors with this code are only counted, see cvui::errors().\n";
+				}
+				return;
+		}
+
 		std::cout << "[CVUI] Fatal error (code " << theId << "): " << theMessage << "\n";
-		cv::waitKey(100000);
+#ifndef CVUI_HEADLESS
+		// Keep the windows (if any) on the screen, so the problem can be inspected.
+		if (gDefaultContext.load() != nullptr && !gPresenterRunning.load()) {
+			cv::waitKey(100000);
+		}
+#endif
 		exit(-1);
 	}
 
@@ -1461,28 +3542,44 @@ namespace internal
 	}
 
 	bool blockStackEmpty() {
-		return gStackCount == -1;
+		return internal::getContext().stackCount == -1;
 	}
 
 	cvui_block_t& topBlock() {
-		if (gStackCount < 0) {
+		cvui_context_t& aContext = internal::getContext();
+
+		if (aContext.stackCount < 0) {
 			error(3, "You are using a function that should be enclosed by begin*() and end*(), but you probably forgot to call begin*().");
+
+			// If the policy allows going on, the component is laid out as if it was rendered at x,y.
+			return aContext.screen;
 		}
 
-		return gStack[gStackCount];
+		return aContext.stack[aContext.stackCount];
 	}
 
 	cvui_block_t& pushBlock() {
-		return gStack[++gStackCount];
+		cvui_context_t& aContext = internal::getContext();
+
+		// The stack only grows, so blocks (and their cv::Mat) are reused among frames. It grows
+		// before the block is counted, since allocation() might throw (see cvui::steadyState()).
+		if (aContext.stackCount + 1 == (int)aContext.stack.size()) {
+			internal::allocation(aContext, "stack", (aContext.stack.size() * 2 + 8) * sizeof(cvui_block_t));
+			aContext.stack.resize(aContext.stack.size() * 2 + 8);
+		}
+
+		return aContext.stack[++aContext.stackCount];
 	}
 
 	cvui_block_t& popBlock() {
+		cvui_context_t& aContext = internal::getContext();
+
 		// Check if there is anything to be popped out from the stack.
-		if (gStackCount < 0) {
+		if (aContext.stackCount < 0) {
 			error(1, "Mismatch in the number of begin*()/end*() calls. You are calling one more than the other.");
 		}
 
-		return gStack[gStackCount--];
+		return aContext.stack[aContext.stackCount--];
 	}
 
 	void begin(int theType, cv::Mat &theWhere, int theX, int theY, int theWidth, int theHeight, int thePadding) {
@@ -1504,15 +3601,32 @@ namespace internal
 
 		aBlock.padding = thePadding;
 		aBlock.type = theType;
+#ifdef CVUI_PROFILER
+		aBlock.start = cv::getTickCount();
+#endif
 	}
 
 	void end(int theType) {
+		if (blockStackEmpty()) {
+			error(1, "Mismatch in the number of begin*()/end*() calls. You are calling one more than the other.");
+			return;
+		}
+
 		cvui_block_t& aBlock = popBlock();
 
+		// If the policy allows going on, the block is closed anyway.
 		if (aBlock.type != theType) {
 			error(4, "Calling wrong type of end*(). E.g. endColumn() instead of endRow(). Check if your begin*() calls are matched with their appropriate end*() calls.");
 		}
 
+#ifdef CVUI_PROFILER
+		cvui_context_t& aContext = internal::getContext();
+
+		if (!aContext.trace.empty()) {
+			internal::traceZone(aContext, aContext.frame, aBlock.type == ROW ? "row" : "column", 0, aBlock.start, cv::getTickCount());
+		}
+#endif
+
 		// If we still have blocks in the stack, we must update
 		// the current top with the dimensions that were filled by
 		// the newly popped block.
@@ -1531,68 +3645,496 @@ namespace internal
 			aSize.width = aBlock.rect.width < 0 ? aBlock.fill.width : aBlock.rect.width;
 			aSize.height = aBlock.rect.height < 0 ? aBlock.fill.height : aBlock.rect.height;
 
-			updateLayoutFlow(aTop, aSize);
+			updateLayoutFlow(aTop, aSize);
+		}
+	}
+
+	// Find the min and max values of a vector
+	void findMinMax(std::vector<double>& theValues, double *theMin, double *theMax) {
+		std::vector<double>::size_type aSize = theValues.size(), i;
+		double aMin = theValues[0], aMax = theValues[0];
+
+		for (i = 0; i < aSize; i++) {
+			if (theValues[i] < aMin) {
+				aMin = theValues[i];
+			}
+
+			if (theValues[i] > aMax) {
+				aMax = theValues[i];
+			}
+		}
+
+		*theMin = aMin;
+		*theMax = aMax;
+	}
+
+	const cvui_label_t& createLabel(const std::string &theLabel) {
+		// The label is parsed into a per-thread buffer, whose strings keep their
+		// storage among calls, so parsing labels does not allocate memory.
+		cvui_label_t& aLabel = internal::gLabel;
+		size_t aCapacity = aLabel.textBeforeShortcut.capacity() + aLabel.textAfterShortcut.capacity();
+
+		aLabel.hasShortcut = false;
+		aLabel.shortcut = 0;
+		aLabel.textBeforeShortcut.clear();
+		aLabel.textAfterShortcut.clear();
+
+		for (size_t i = 0; i < theLabel.size(); i++) {
+			char c = theLabel[i];
+			if ((c == '&') && (i < theLabel.size() - 1)) {
+				aLabel.hasShortcut = true;
+				aLabel.shortcut = theLabel[i + 1];
+				++i;
+			}
+			else if (!aLabel.hasShortcut) {
+				aLabel.textBeforeShortcut.push_back(c);
+			}
+			else {
+				aLabel.textAfterShortcut.push_back(c);
+			}
+		}
+
+		if (aLabel.textBeforeShortcut.capacity() + aLabel.textAfterShortcut.capacity() != aCapacity) {
+			internal::allocation("label", theLabel.size());
+		}
+
+		return aLabel;
+	}
+
+	const std::string& bufferText() {
+		size_t aLength = strlen(internal::gBuffer);
+
+		if (aLength > internal::gText.capacity()) {
+			internal::allocation("text", aLength + 1);
+		}
+
+		internal::gText = internal::gBuffer;
+		return internal::gText;
+	}
+
+	cv::Mat scratch(cv::Size theSize, int theType) {
+		cv::Mat& aScratch = internal::gScratch;
+
+		// The storage only grows, so it is allocated in the first frames only.
+		if (aScratch.type() != theType || aScratch.cols < theSize.width || aScratch.rows < theSize.height) {
+			cv::Size aSize(std::max(aScratch.cols, theSize.width), std::max(aScratch.rows, theSize.height));
+
+			internal::allocation("scratch", aSize.area() * CV_ELEM_SIZE(theType));
+			aScratch.create(aSize, theType);
+		}
+
+		return aScratch(cv::Rect(cv::Point(0, 0), theSize));
+	}
+
+	void allocation(const char *theSite, size_t theSize) {
+		internal::allocation(internal::getContext(), theSite, theSize);
+	}
+
+	// Must not be called while gContextsMutex is locked, because the error might call back into cvui.
+	void allocation(cvui_context_t& theContext, const char *theSite, size_t theSize) {
+		cvui_context_t& aContext = theContext;
+
+		aContext.allocations++;
+		CVUI_PROFILE_COUNT(PROFILE_ALLOCATIONS);
+
+		if (internal::gAllocationHook != nullptr) {
+			internal::gAllocationHook(theSite, theSize, internal::gAllocationHookData);
+		}
+
+		if (aContext.steadyState && aContext.frame >= aContext.steadyStateStart) {
+			// gBuffer might hold the text being allocated for, so it is not used here.
+			char aMessage[512];
+			sprintf_s(aMessage, "Heap allocation (%s, %u bytes) in window \"%s\" after the warm-up frames of steady-state mode. Check what is different in the frames of your UI, e.g. components being added, or increase the amount of warm-up frames.", theSite, (unsigned int)theSize, aContext.windowName.c_str());
+			internal::error(aContext, 9, aMessage);
+		}
+	}
+
+	cv::Scalar hexToScalar(unsigned int theColor) {
+		int aAlpha = (theColor >> 24) & 0xff;
+		int aRed = (theColor >> 16) & 0xff;
+		int aGreen = (theColor >> 8) & 0xff;
+		int aBlue = theColor & 0xff;
+
+		return cv::Scalar(aBlue, aGreen, aRed, aAlpha);
+	}
+
+	void prepareTheme(cvui_theme_t& theTheme) {
+		unsigned int aButton = theTheme.colors[THEME_BUTTON];
+		unsigned int aBevel = theTheme.colors[THEME_BUTTON_BEVEL];
+		unsigned int aHighlight = theTheme.colors[THEME_BUTTON_HIGHLIGHT];
+
+		for (int i = 0; i < THEME_COLORS; i++) {
+			theTheme.scalars[i] = internal::hexToScalar(theTheme.colors[i]);
+		}
+
+		theTheme.scalars[THEME_BUTTON_BRIGHT] = internal::hexToScalar(internal::brightenColor(aButton, aBevel));
+		theTheme.scalars[THEME_BUTTON_DARK] = internal::hexToScalar(internal::darkenColor(aButton, aBevel));
+		theTheme.scalars[THEME_BUTTON_OVER] = internal::hexToScalar(internal::brightenColor(aButton, aHighlight));
+		theTheme.scalars[THEME_BUTTON_DOWN] = internal::hexToScalar(internal::darkenColor(aButton, aHighlight));
+		theTheme.scalars[THEME_BUTTON_LABEL] = theTheme.scalars[internal::brightnessOfColor(aButton) < 0x80 ? THEME_TEXT : THEME_TEXT_DARK];
+		memcpy(theTheme.prepared, theTheme.colors, sizeof(theTheme.prepared));
+	}
+
+	inline const cvui_theme_t& theme() {
+		const cvui_theme_t *aTheme = gTheme.load(std::memory_order_acquire);
+		return aTheme != nullptr ? *aTheme : gDefaultTheme;
+	}
+
+	bool skin(cv::Mat& theWhere, int theSkin, int theState, const cv::Rect& theRect) {
+		int aChannels = theWhere.channels();
+		cv::Mat aImage, aAlpha;
+
+		if (!internal::gSkinned.load(std::memory_order_acquire) || theWhere.depth() != CV_8U || (aChannels != 1 && aChannels != 3 && aChannels != 4) || theRect.width <= 0 || theRect.height <= 0) {
+			return false;
+		}
+
+		cvui_skin_t *aSkin = nullptr;
+		cvui_skin_t aSource;
+		cvui_skin_cache_t aStretched;
+		size_t aGrowth = 0;
+
+		{
+			std::lock_guard<std::mutex> aLock(internal::gSkinsMutex);
+			aSkin = &internal::gSkins[theSkin][theState == OUT ? 0 : (theState == OVER ? 1 : 2)];
+
+			// States without a skin of their own use the skin of OUT.
+			if (aSkin->image.empty()) {
+				aSkin = &internal::gSkins[theSkin][0];
+			}
+
+			if (aSkin->image.empty()) {
+				return false;
+			}
+
+			// The stretched skin is referenced, so it can be used after the lock is released.
+			cvui_skin_cache_t *aEntry = internal::skinCache(*aSkin, theRect.size(), theWhere.type());
+
+			if (aEntry != nullptr) {
+				aImage = aEntry->image;
+				aAlpha = aEntry->alpha;
+			} else {
+				// Images of skins are replaced, never changed, so the reference stays valid.
+				aSource.image = aSkin->image;
+				aSource.left = aSkin->left;
+				aSource.top = aSkin->top;
+				aSource.right = aSkin->right;
+				aSource.bottom = aSkin->bottom;
+			}
+		}
+
+		// Not stretched to this size yet. Stretching happens without the lock, so other
+		// threads keep rendering skins meanwhile, and so does reporting allocations,
+		// whose error callback might set skins or render skinned components.
+		if (aImage.empty()) {
+			internal::skinStretch(aSource, theRect.size(), theWhere.type(), aStretched);
+			aImage = aStretched.image;
+			aAlpha = aStretched.alpha;
+
+			std::lock_guard<std::mutex> aLock(internal::gSkinsMutex);
+			std::vector<cvui_skin_cache_t>& aCache = aSkin->cache;
+
+			// Unless the skin was replaced or another thread got there first.
+			if (aSkin->image.data == aSource.image.data && internal::skinCache(*aSkin, theRect.size(), theWhere.type()) == nullptr) {
+				aGrowth = aCache.size() == aCache.capacity() ? (aCache.capacity() + 1) * sizeof(cvui_skin_cache_t) : 0;
+				aStretched.use = internal::gSkinFrame.load(std::memory_order_relaxed);
+				aCache.push_back(aStretched);
+			}
+		}
+
+		if (aGrowth > 0) {
+			internal::allocation("skins", aGrowth);
+		}
+
+		internal::skinBlend(theWhere, theRect, aImage, aAlpha);
+		return true;
+	}
+
+	cvui_skin_cache_t *skinCache(cvui_skin_t& theSkin, cv::Size theSize, int theType) {
+		std::vector<cvui_skin_cache_t>& aCache = theSkin.cache;
+		unsigned int aFrame = internal::gSkinFrame.load(std::memory_order_relaxed);
+		size_t i = 0;
+
+		// The cache holds every size in use, however many there are. Sizes not used
+		// for a while (e.g. of a button that changed its label) are dropped on the way.
+		while (i < aCache.size()) {
+			if (aCache[i].size == theSize && aCache[i].type == theType) {
+				CVUI_PROFILE_COUNT(PROFILE_CACHE_HITS);
+				aCache[i].use = aFrame;
+				return &aCache[i];
+			}
+
+			if (aFrame - aCache[i].use > gSkinLifetime) {
+				std::swap(aCache[i], aCache.back());
+				aCache.pop_back();
+			} else {
+				i++;
+			}
+		}
+
+		// Not stretched to this size yet, see internal::skin().
+		return nullptr;
+	}
+
+	void skinStretch(const cvui_skin_t& theSkin, cv::Size theSize, int theType, cvui_skin_cache_t& theEntry) {
+		const cv::Mat& aSource = theSkin.image;
+		int aSourceChannels = aSource.channels();
+		int aChannels = CV_MAT_CN(theType);
+
+		internal::allocation("skins", theSize.area() * (aSource.elemSize() + CV_ELEM_SIZE(theType) + 1));
+		cv::Mat aStretched(theSize, aSource.type());
+
+		// Borders keep their size, unless the component is too small for them.
+		int aLeft = theSkin.left, aRight = theSkin.right, aTop = theSkin.top, aBottom = theSkin.bottom;
+
+		if (aLeft + aRight > theSize.width) {
+			aLeft = aLeft * theSize.width / (aLeft + aRight);
+			aRight = theSize.width - aLeft;
+		}
+		if (aTop + aBottom > theSize.height) {
+			aTop = aTop * theSize.height / (aTop + aBottom);
+			aBottom = theSize.height - aTop;
+		}
+
+		int aSourceX[4] = { 0, theSkin.left, aSource.cols - theSkin.right, aSource.cols };
+		int aSourceY[4] = { 0, theSkin.top, aSource.rows - theSkin.bottom, aSource.rows };
+		int aTargetX[4] = { 0, aLeft, theSize.width - aRight, theSize.width };
+		int aTargetY[4] = { 0, aTop, theSize.height - aBottom, theSize.height };
+
+		for (int j = 0; j < 3; j++) {
+			for (int i = 0; i < 3; i++) {
+				cv::Rect aFrom(aSourceX[i], aSourceY[j], aSourceX[i + 1] - aSourceX[i], aSourceY[j + 1] - aSourceY[j]);
+				cv::Rect aTo(aTargetX[i], aTargetY[j], aTargetX[i + 1] - aTargetX[i], aTargetY[j + 1] - aTargetY[j]);
+
+				if (aFrom.area() > 0 && aTo.area() > 0) {
+					cv::Mat aSlice = aStretched(aTo);
+					cv::resize(aSource(aFrom), aSlice, aTo.size(), 0, 0, aFrom.size() == aTo.size() ? cv::INTER_NEAREST : cv::INTER_LINEAR);
+				}
+			}
+		}
+
+		// Convert the skin to the type it is rendered into once, so rendering is a plain copy.
+		bool aOpaque = true;
+		theEntry.size = theSize;
+		theEntry.type = theType;
+		theEntry.image.create(theSize, theType);
+		theEntry.alpha.create(theSize, CV_8UC1);
+
+		for (int y = 0; y < theSize.height; y++) {
+			const uchar *aFrom = aStretched.ptr<uchar>(y);
+			uchar *aTo = theEntry.image.ptr<uchar>(y);
+			uchar *aAlpha = theEntry.alpha.ptr<uchar>(y);
+
+			for (int x = 0; x < theSize.width; x++, aFrom += aSourceChannels, aTo += aChannels) {
+				int aBlue = aFrom[0], aGreen = aSourceChannels == 1 ? aFrom[0] : aFrom[1], aRed = aSourceChannels == 1 ? aFrom[0] : aFrom[2];
+
+				if (aChannels == 1) {
+					// Same weights as cv::COLOR_BGR2GRAY.
+					aTo[0] = (uchar)((aBlue * 1868 + aGreen * 9617 + aRed * 4899 + 8192) >> 14);
+				} else {
+					aTo[0] = (uchar)aBlue; aTo[1] = (uchar)aGreen; aTo[2] = (uchar)aRed;
+
+					// Opaque, like everything else cvui renders. Skins with alpha blend it below.
+					if (aChannels == 4) {
+						aTo[3] = 0xff;
+					}
+				}
+
+				aAlpha[x] = aSourceChannels == 4 ? aFrom[3] : 0xff;
+				aOpaque = aOpaque && aAlpha[x] == 0xff;
+			}
+		}
+
+		if (aOpaque) {
+			theEntry.alpha.release();
+		}
+	}
+
+	void skinBlend(cv::Mat& theWhere, const cv::Rect& theRect, const cv::Mat& theImage, const cv::Mat& theAlpha) {
+		cv::Rect aVisible = theRect & cv::Rect(0, 0, theWhere.cols, theWhere.rows);
+
+		if (aVisible.area() <= 0) {
+			return;
+		}
+
+		cv::Rect aFrom(aVisible.tl() - theRect.tl(), aVisible.size());
+		CVUI_PROFILE_COUNT(PROFILE_PRIMITIVES);
+
+		if (theAlpha.empty()) {
+			theImage(aFrom).copyTo(theWhere(aVisible));
+			return;
+		}
+
+		int aChannels = theWhere.channels();
+
+		for (int y = 0; y < aVisible.height; y++) {
+			const uchar *aSkin = theImage.ptr<uchar>(aFrom.y + y) + aFrom.x * aChannels;
+			const uchar *aAlpha = theAlpha.ptr<uchar>(aFrom.y + y) + aFrom.x;
+			uchar *aTarget = theWhere.ptr<uchar>(aVisible.y + y) + aVisible.x * aChannels;
+
+			for (int x = 0; x < aVisible.width; x++) {
+				unsigned int aOpacity = aAlpha[x];
+
+				for (int c = 0; c < aChannels; c++, aSkin++, aTarget++) {
+					unsigned int aValue = *aSkin * aOpacity + *aTarget * (0xff - aOpacity) + 128;
+					*aTarget = (uchar)((aValue + (aValue >> 8)) >> 8);
+				}
+			}
+		}
+	}
+
+	inline cv::Scalar targetColor(const cv::Mat& theWhere, const cv::Scalar& theColor) {
+		int aDepth = theWhere.depth();
+		int aChannels = theWhere.channels();
+		bool aGray = aChannels == 1;
+
+		// Colors of cvui are BGR with 8 bits per channel, which is what most frames are.
+		if (aChannels == 3 && aDepth != CV_16U) {
+			return theColor;
+		}
+
+		double aBlue = theColor[0], aGreen = theColor[1], aRed = theColor[2], aAlpha = theColor[3];
+
+		if (aChannels == 4) {
+			// The alpha of cvui colors is a transparency (0 is opaque), while the 4th channel
+			// of frames is an opacity, like in any BGRA image.
+			aAlpha = 0xff - aAlpha;
+		}
+
+		if (aGray) {
+			// Same weights (and rounding) as cv::COLOR_BGR2GRAY, so colors match the images converted by convertImage().
+			aBlue = aGreen = aRed = (((int)aBlue * 1868 + (int)aGreen * 9617 + (int)aRed * 4899) + (1 << 13)) >> 14;
+		}
+
+		if (aDepth == CV_16U) {
+			// 0xff becomes 0xffff, so the whole range of the frame is used.
+			aBlue *= 257; aGreen *= 257; aRed *= 257; aAlpha *= 257;
+		}
+
+		return cv::Scalar(aBlue, aGreen, aRed, aAlpha);
+	}
+
+	bool rawPixel(const cv::Mat& theWhere, const cv::Scalar& theColor, uchar *thePixel) {
+		int aChannels = theWhere.channels();
+		int aDepth = theWhere.depth();
+
+		if ((aDepth != CV_8U && aDepth != CV_16U) || (aChannels != 1 && aChannels != 3 && aChannels != 4)) {
+			return false;
 		}
-	}
 
-	// Find the min and max values of a vector
-	void findMinMax(std::vector<double>& theValues, double *theMin, double *theMax) {
-		std::vector<double>::size_type aSize = theValues.size(), i;
-		double aMin = theValues[0], aMax = theValues[0];
+		cv::Scalar aColor = internal::targetColor(theWhere, theColor);
 
-		for (i = 0; i < aSize; i++) {
-			if (theValues[i] < aMin) {
-				aMin = theValues[i];
+		// Same conversion OpenCV applies to the color of its drawing functions.
+		for (int c = 0; c < aChannels; c++) {
+			if (aDepth == CV_8U) {
+				thePixel[c] = cv::saturate_cast<uchar>(aColor[c]);
+			} else {
+				ushort aValue = cv::saturate_cast<ushort>(aColor[c]);
+				memcpy(thePixel + c * sizeof(ushort), &aValue, sizeof(ushort));
 			}
+		}
 
-			if (theValues[i] > aMax) {
-				aMax = theValues[i];
+		return true;
+	}
+
+	void fillSpan(cv::Mat& theWhere, int theX1, int theY1, int theX2, int theY2, const uchar *thePixel) {
+		int aX1 = std::max(theX1, 0), aX2 = std::min(theX2, theWhere.cols - 1);
+		int aY1 = std::max(theY1, 0), aY2 = std::min(theY2, theWhere.rows - 1);
+
+		if (aX1 > aX2 || aY1 > aY2) {
+			return;
+		}
+
+		// The first row is written pixel by pixel, the others are copies of it.
+		size_t aPixelSize = theWhere.elemSize();
+		size_t aBytes = (size_t)(aX2 - aX1 + 1) * aPixelSize;
+		uchar *aFirst = theWhere.ptr<uchar>(aY1) + aX1 * aPixelSize;
+
+		if (aPixelSize == 1) {
+			memset(aFirst, thePixel[0], aBytes);
+		} else {
+			for (size_t i = 0; i < aBytes; i += aPixelSize) {
+				memcpy(aFirst + i, thePixel, aPixelSize);
 			}
 		}
 
-		*theMin = aMin;
-		*theMax = aMax;
+		for (int y = aY1 + 1; y <= aY2; y++) {
+			memcpy(theWhere.ptr<uchar>(y) + aX1 * aPixelSize, aFirst, aBytes);
+		}
 	}
 
-	cvui_label_t createLabel(const std::string &theLabel) {
-		cvui_label_t aLabel;
-		std::stringstream aBefore, aAfter;
+	void line(cv::Mat& theWhere, cv::Point thePoint1, cv::Point thePoint2, const cv::Scalar& theColor) {
+		uchar aPixel[8];
 
-		aLabel.hasShortcut = false;
-		aLabel.shortcut = 0;
-		aLabel.textBeforeShortcut = "";
-		aLabel.textAfterShortcut = "";
+		// cv::line() covers both ends of horizontal and vertical lines, which is easy to do row by row.
+		if ((thePoint1.x != thePoint2.x && thePoint1.y != thePoint2.y) || !internal::rawPixel(theWhere, theColor, aPixel)) {
+			cv::line(theWhere, thePoint1, thePoint2, internal::targetColor(theWhere, theColor));
+			return;
+		}
 
-		for (size_t i = 0; i < theLabel.size(); i++) {
-			char c = theLabel[i];
-			if ((c == '&') && (i < theLabel.size() - 1)) {
-				aLabel.hasShortcut = true;
-				aLabel.shortcut = theLabel[i + 1];
-				++i;
-			}
-			else if (!aLabel.hasShortcut) {
-				aBefore << c;
-			}
-			else {
-				aAfter << c;
-			}
+		internal::fillSpan(theWhere, std::min(thePoint1.x, thePoint2.x), std::min(thePoint1.y, thePoint2.y), std::max(thePoint1.x, thePoint2.x), std::max(thePoint1.y, thePoint2.y), aPixel);
+	}
+
+	void rectangle(cv::Mat& theWhere, const cv::Rect& theRect, const cv::Scalar& theColor, int theThickness) {
+		uchar aPixel[8];
+
+		// Versions of OpenCV disagree on rects with negative sizes, so those are left to OpenCV itself.
+		if ((theThickness != 1 && theThickness != CVUI_FILLED) || theRect.width < 0 || theRect.height < 0 || !internal::rawPixel(theWhere, theColor, aPixel)) {
+			cv::rectangle(theWhere, theRect, internal::targetColor(theWhere, theColor), theThickness);
+			return;
 		}
 
-		aLabel.textBeforeShortcut = aBefore.str();
-		aLabel.textAfterShortcut = aAfter.str();
+		// Like cv::rectangle(), which goes from theRect.tl() to theRect.br() - (1, 1), both included,
+		// and draws nothing if the rect is empty.
+		if (theRect.area() <= 0) {
+			return;
+		}
 
-		return aLabel;
+		int aX1 = theRect.x, aX2 = theRect.x + theRect.width - 1;
+		int aY1 = theRect.y, aY2 = theRect.y + theRect.height - 1;
+
+		if (theThickness == CVUI_FILLED) {
+			internal::fillSpan(theWhere, aX1, aY1, aX2, aY2, aPixel);
+		} else {
+			internal::fillSpan(theWhere, aX1, aY1, aX2, aY1, aPixel);
+			internal::fillSpan(theWhere, aX1, aY2, aX2, aY2, aPixel);
+			internal::fillSpan(theWhere, aX1, aY1, aX1, aY2, aPixel);
+			internal::fillSpan(theWhere, aX2, aY1, aX2, aY2, aPixel);
+		}
 	}
 
-	cv::Scalar hexToScalar(unsigned int theColor) {
-		int aAlpha = (theColor >> 24) & 0xff;
-		int aRed = (theColor >> 16) & 0xff;
-		int aGreen = (theColor >> 8) & 0xff;
-		int aBlue = theColor & 0xff;
+	void putText(cv::Mat& theWhere, const cv::String& theText, cv::Point thePosition, double theFontScale, const cv::Scalar& theColor) {
+		cv::putText(theWhere, theText, thePosition, cv::FONT_HERSHEY_SIMPLEX, theFontScale, internal::targetColor(theWhere, theColor), 1, CVUI_ANTIALISED);
+	}
 
-		return cv::Scalar(aBlue, aGreen, aRed, aAlpha);
+	void convertImage(const cv::Mat& theImage, cv::Mat& theTarget) {
+		int aChannels = theImage.channels();
+		bool aSameDepth = theImage.depth() == theTarget.depth();
+		cv::Mat aColors = theImage;
+
+		// Channels are converted first, in the depth of the image, then the depth is converted.
+		if (aChannels != theTarget.channels()) {
+			aColors = aSameDepth ? theTarget : internal::scratch(theImage.size(), CV_MAKETYPE(theImage.depth(), theTarget.channels()));
+
+			if (theTarget.channels() == 1) {
+				cv::cvtColor(theImage, aColors, aChannels == 4 ? cv::COLOR_BGRA2GRAY : cv::COLOR_BGR2GRAY);
+			} else if (theTarget.channels() == 3) {
+				cv::cvtColor(theImage, aColors, aChannels == 4 ? cv::COLOR_BGRA2BGR : cv::COLOR_GRAY2BGR);
+			} else {
+				// Images without alpha are opaque.
+				int aFromTo[] = { 0, 0, aChannels == 1 ? 0 : 1, 1, aChannels == 1 ? 0 : 2, 2 };
+				aColors.setTo(cv::Scalar(0, 0, 0, theImage.depth() == CV_16U ? 0xffff : 0xff));
+				cv::mixChannels(&theImage, 1, &aColors, 1, aFromTo, 3);
+			}
+		}
+
+		if (!aSameDepth) {
+			double aScale = theTarget.depth() == CV_16U && aColors.depth() == CV_8U ? 257.0 : (theTarget.depth() == CV_8U && aColors.depth() == CV_16U ? 1.0 / 257.0 : 1.0);
+			aColors.convertTo(theTarget, theTarget.depth(), aScale);
+		} else if (aColors.data != theTarget.data) {
+			aColors.copyTo(theTarget);
+		}
 	}
-	
+
 	unsigned int brightenColor(unsigned int theColor, unsigned int theDelta)
 	{
 		cv::Scalar color = hexToScalar(theColor);
@@ -1672,7 +4214,7 @@ namespace internal
 	}
 
 	int iarea(int theX, int theY, int theWidth, int theHeight) {
-		cvui_mouse_t& aMouse = internal::getContext().mouse;
+		cvui_mouse_t& aMouse = internal::input(internal::getContext()).mouse;
 
 		// By default, return that the mouse is out of the interaction area.
 		int aRet = cvui::OUT;
@@ -1697,7 +4239,11 @@ namespace internal
 	}
 
 	bool button(cvui_block_t& theBlock, int theX, int theY, int theWidth, int theHeight, const cv::String& theLabel, bool theUpdateLayout, double theFontScale, unsigned int theInsideColor) {
+		CVUI_PROFILE_ZONE(PROFILE_BUTTON);
+		internal::widgetId(theLabel.c_str(), theX, theY);
+
 		// Calculate the space that the label will fill
+		CVUI_PROFILE_COUNT(PROFILE_TEXT_MEASUREMENTS);
 		cv::Size aTextSize = getTextSize(theLabel, cv::FONT_HERSHEY_SIMPLEX, theFontScale, 1, nullptr);
 
 		// Make the button bit enough to house the label
@@ -1715,16 +4261,8 @@ namespace internal
 			updateLayoutFlow(theBlock, aSize);
 		}
 
-		bool aWasShortcutPressed = false;
-
 		//Handle keyboard shortcuts
-		if (internal::gLastKeyPressed != -1) {
-			// TODO: replace with something like strpos(). I think it has better performance.
-			auto aLabel = internal::createLabel(theLabel);
-			if (aLabel.hasShortcut && (tolower(aLabel.shortcut) == tolower((char)internal::gLastKeyPressed))) {
-				aWasShortcutPressed = true;
-			}
-		}
+		bool aWasShortcutPressed = internal::consumeShortcut(internal::input(internal::getContext()), theLabel);
 
 		// Return true if the button was clicked
 		return aStatus == cvui::CLICK || aWasShortcutPressed;
@@ -1732,6 +4270,7 @@ namespace internal
 
 	bool button(cvui_block_t& theBlock, int theX, int theY, const cv::String& theLabel, double theFontScale, unsigned int theInsideColor) {
 		// Calculate the space that the label will fill
+		CVUI_PROFILE_COUNT(PROFILE_TEXT_MEASUREMENTS);
 		cv::Size aTextSize = getTextSize(theLabel, cv::FONT_HERSHEY_SIMPLEX, theFontScale, 1, nullptr);
 
 		// Create a button based on the size of the text. The size of the additional area outside the label depends on the font size.
@@ -1739,6 +4278,9 @@ namespace internal
 	}
 
 	bool button(cvui_block_t& theBlock, int theX, int theY, cv::Mat& theIdle, cv::Mat& theOver, cv::Mat& theDown, bool theUpdateLayout) {
+		CVUI_PROFILE_ZONE(PROFILE_BUTTON);
+		internal::widgetId(nullptr, theX, theY);
+
 		cv::Rect aRect(theX, theY, theIdle.cols, theIdle.rows);
 		int aStatus = cvui::iarea(theX, theY, aRect.width, aRect.height);
 
@@ -1760,6 +4302,9 @@ namespace internal
 	}
 
 	void image(cvui_block_t& theBlock, int theX, int theY, cv::Mat& theImage) {
+		CVUI_PROFILE_ZONE(PROFILE_IMAGE);
+		internal::widgetId(nullptr, theX, theY);
+
 		cv::Rect aRect(theX, theY, theImage.cols, theImage.rows);
 
 		// TODO: check for render outside the frame area
@@ -1771,8 +4316,12 @@ namespace internal
 	}
 
 	bool checkbox(cvui_block_t& theBlock, int theX, int theY, const cv::String& theLabel, bool *theState, unsigned int theColor, double theFontScale) {
-		cvui_mouse_t& aMouse = internal::getContext().mouse;
+		CVUI_PROFILE_ZONE(PROFILE_CHECKBOX);
+		internal::widgetId(theLabel.c_str(), theX, theY);
+
+		cvui_mouse_t& aMouse = internal::input(internal::getContext()).mouse;
 		cv::Rect aRect(theX, theY, 15, 15);
+		CVUI_PROFILE_COUNT(PROFILE_TEXT_MEASUREMENTS);
 		cv::Size aTextSize = getTextSize(theLabel, cv::FONT_HERSHEY_SIMPLEX, theFontScale, 1, nullptr);
 		cv::Rect aHitArea(theX, theY, aRect.width + aTextSize.width + 6, aRect.height);
 		bool aMouseIsOver = aHitArea.contains(aMouse.position);
@@ -1801,6 +4350,11 @@ namespace internal
 	}
 
 	void text(cvui_block_t& theBlock, int theX, int theY, const cv::String& theText, double theFontScale, unsigned int theColor, bool theUpdateLayout) {
+		CVUI_PROFILE_ZONE(PROFILE_TEXT);
+		// The content of a text might change every frame (e.g. printf()), so it is not part of the id.
+		internal::widgetId(nullptr, theX, theY);
+
+		CVUI_PROFILE_COUNT(PROFILE_TEXT_MEASUREMENTS);
 		cv::Size aTextSize = cv::getTextSize(theText, cv::FONT_HERSHEY_SIMPLEX, theFontScale, 1, nullptr);
 		cv::Point aPos(theX, theY + aTextSize.height);
 
@@ -1815,6 +4369,9 @@ namespace internal
 	}
 
 	int counter(cvui_block_t& theBlock, int theX, int theY, int *theValue, int theStep, const char *theFormat, double theFontScale, unsigned int theInsideColor) {
+		CVUI_PROFILE_ZONE(PROFILE_COUNTER);
+		// The buttons of the counter have their own ids, so we restore ours at the end.
+		unsigned int aId = internal::widgetId(nullptr, theX, theY);
 		const double scale = theFontScale / DEFAULT_FONT_SCALE;
 		cv::Rect aContentArea(std::lround(theX + 22* scale), theY, std::lround(48*scale), std::lround(22*scale));
 
@@ -1823,7 +4380,7 @@ namespace internal
 		}
 
 		sprintf_s(internal::gBuffer, theFormat, *theValue);
-		render::counter(theBlock, aContentArea, internal::gBuffer, theFontScale);
+		render::counter(theBlock, aContentArea, internal::bufferText(), theFontScale);
 
 		if (internal::button(theBlock, aContentArea.x + aContentArea.width, theY, std::lround(22 * scale), std::lround(22 * scale), "+", false, theFontScale, theInsideColor)) {
 			*theValue += theStep;
@@ -1833,10 +4390,14 @@ namespace internal
 		cv::Size aSize(std::lround(22 * scale) * 2 + aContentArea.width, aContentArea.height);
 		updateLayoutFlow(theBlock, aSize);
 
+		internal::getContext().lastId = aId;
 		return *theValue;
 	}
 
 	double counter(cvui_block_t& theBlock, int theX, int theY, double *theValue, double theStep, const char *theFormat, double theFontScale, unsigned int theInsideColor) {
+		CVUI_PROFILE_ZONE(PROFILE_COUNTER);
+		// The buttons of the counter have their own ids, so we restore ours at the end.
+		unsigned int aId = internal::widgetId(nullptr, theX, theY);
 		const double scale = theFontScale / DEFAULT_FONT_SCALE;
 		cv::Rect aContentArea(std::lround(theX + 22 * scale), theY, 48, std::lround(22 * scale));
 
@@ -1845,7 +4406,7 @@ namespace internal
 		}
 
 		sprintf_s(internal::gBuffer, theFormat, *theValue);
-		render::counter(theBlock, aContentArea, internal::gBuffer, theFontScale);
+		render::counter(theBlock, aContentArea, internal::bufferText(), theFontScale);
 
 		if (internal::button(theBlock, aContentArea.x + aContentArea.width, theY, std::lround(22 * scale), std::lround(22 * scale), "+", false, theFontScale, theInsideColor)) {
 			*theValue += theStep;
@@ -1855,11 +4416,15 @@ namespace internal
 		cv::Size aSize(std::lround(22 * scale) * 2 + aContentArea.width, aContentArea.height);
 		updateLayoutFlow(theBlock, aSize);
 
+		internal::getContext().lastId = aId;
 		return *theValue;
 	}
 
 	bool trackbar(cvui_block_t& theBlock, int theX, int theY, int theWidth, long double *theValue, const TrackbarParams & theParams) {
-		cvui_mouse_t& aMouse = internal::getContext().mouse;
+		CVUI_PROFILE_ZONE(PROFILE_TRACKBAR);
+		internal::widgetId(nullptr, theX, theY);
+
+		cvui_mouse_t& aMouse = internal::input(internal::getContext()).mouse;
 		cv::Rect aContentArea(theX, theY, theWidth, std::lround(45*theParams.fontScale/DEFAULT_FONT_SCALE));
 		long double aValue = *theValue;
 		bool aMouseIsOver = aContentArea.contains(aMouse.position);
@@ -1883,7 +4448,10 @@ namespace internal
 
 
 	void window(cvui_block_t& theBlock, int theX, int theY, int theWidth, int theHeight, const cv::String& theTitle, double theFontScale) {
-		cv::Rect aTitleBar(theX, theY, theWidth, std::lround(20*theFontScale/DEFAULT_FONT_SCALE));
+		CVUI_PROFILE_ZONE(PROFILE_WINDOW);
+		internal::widgetId(theTitle.c_str(), theX, theY);
+
+		cv::Rect aTitleBar(theX, theY, theWidth, std::lround(internal::theme().windowTitleHeight * theFontScale / DEFAULT_FONT_SCALE));
 		cv::Rect aContent(theX, theY + aTitleBar.height, theWidth, theHeight - aTitleBar.height);
 
 		render::window(theBlock, aTitleBar, aContent, theTitle, theFontScale);
@@ -1894,6 +4462,9 @@ namespace internal
 	}
 
 	void rect(cvui_block_t& theBlock, int theX, int theY, int theWidth, int theHeight, unsigned int theBorderColor, unsigned int theFillingColor) {
+		CVUI_PROFILE_ZONE(PROFILE_RECT);
+		internal::widgetId(nullptr, theX, theY);
+
 		cv::Point aAnchor(theX, theY);
 		cv::Rect aRect(theX, theY, theWidth, theHeight);
 		
@@ -1910,6 +4481,9 @@ namespace internal
 	}
 
 	void sparkline(cvui_block_t& theBlock, std::vector<double>& theValues, int theX, int theY, int theWidth, int theHeight, unsigned int theColor) {
+		CVUI_PROFILE_ZONE(PROFILE_SPARKLINE);
+		unsigned int aId = internal::widgetId(nullptr, theX, theY);
+
 		double aMin, aMax;
 		cv::Rect aRect(theX, theY, theWidth, theHeight);
 		std::vector<double>::size_type aHowManyValues = theValues.size();
@@ -1918,12 +4492,387 @@ namespace internal
 			internal::findMinMax(theValues, &aMin, &aMax);
 			render::sparkline(theBlock, theValues, aRect, aMin, aMax, theColor);
 		} else {
-			internal::text(theBlock, theX, theY, aHowManyValues == 0 ? "No data." : "Insufficient data points.", DEFAULT_FONT_SCALE, 0xCECECE, false);
+			internal::text(theBlock, theX, theY, aHowManyValues == 0 ? "No data." : "Insufficient data points.", DEFAULT_FONT_SCALE, internal::theme().colors[THEME_TEXT], false);
+			internal::getContext().lastId = aId;
+		}
+
+		// Update the layout flow
+		cv::Size aSize(theWidth, theHeight);
+		updateLayoutFlow(theBlock, aSize);
+	}
+
+	void tableCache(cvui_table_t *theTable, int theRows, int theColumns, int theCapacity) {
+		// If the geometry of the table changed or rows were removed, the cached
+		// text might belong to rows that no longer exist, so we start over.
+		if (theTable->capacity != theCapacity || theTable->columns != theColumns || theRows < theTable->rows) {
+			theTable->capacity = theCapacity;
+			theTable->columns = theColumns;
+			theTable->cachedRows.assign(theCapacity, -1);
+			internal::allocation("table", (size_t)theCapacity * theColumns * sizeof(std::string));
+			theTable->cells.resize((size_t)theCapacity * theColumns);
+		}
+
+		theTable->rows = theRows;
+	}
+
+	void tableFormatRow(cvui_table_t *theTable, int theRow, cvui_table_cell_t theCell, void *theData) {
+		int aSlot = theRow % theTable->capacity;
+
+		if (theTable->cachedRows[aSlot] == theRow) {
+			// Row is already formatted, nothing to do.
+			CVUI_PROFILE_COUNT(PROFILE_CACHE_HITS);
+			return;
+		}
+
+		for (int c = 0; c < theTable->columns; c++) {
+			internal::gBuffer[0] = '\0';
+			theCell(theRow, c, internal::gBuffer, sizeof(internal::gBuffer), theData);
+			internal::gBuffer[sizeof(internal::gBuffer) - 1] = '\0';
+
+			std::string& aCell = theTable->cells[aSlot * theTable->columns + c];
+			size_t aLength = strlen(internal::gBuffer);
+
+			// Cells keep their storage, so they only allocate if the text grows.
+			if (aLength > aCell.capacity()) {
+				internal::allocation("table", aLength + 1);
+			}
+			aCell = internal::gBuffer;
+		}
+
+		theTable->cachedRows[aSlot] = theRow;
+	}
+
+	int table(cvui_block_t& theBlock, int theX, int theY, int theWidth, int theHeight, cvui_table_t *theTable, int theRows, int theColumns, const cv::String theHeaders[], const int theColumnWidths[], cvui_table_cell_t theCell, void *theData, double theFontScale) {
+		CVUI_PROFILE_ZONE(PROFILE_TABLE);
+		internal::widgetId(nullptr, theX, theY);
+
+		cvui_mouse_t& aMouse = internal::input(internal::getContext()).mouse;
+		const double aScale = theFontScale / DEFAULT_FONT_SCALE;
+		int aRowHeight = std::max(1, (int)std::lround(20 * aScale));
+		int aHeaderHeight = theHeaders != nullptr ? aRowHeight : 0;
+
+		cv::Rect aRect(theX, theY, theWidth, theHeight);
+		cv::Rect aBody(theX, theY + aHeaderHeight, theWidth, std::max(0, theHeight - aHeaderHeight));
+
+		// Rows that fit entirely in the body define how far we can scroll, while
+		// rows that are at least partially visible are the ones we have to render.
+		int aFullRows = std::max(1, aBody.height / aRowHeight);
+		int aVisibleRows = std::max(1, (aBody.height + aRowHeight - 1) / aRowHeight);
+		int aMaxScroll = std::max(0, theRows - aFullRows);
+
+		bool aHasScrollbar = theRows > aFullRows;
+		int aScrollbarWidth = aHasScrollbar ? (int)std::lround(10 * aScale) : 0;
+		cv::Rect aScrollbar(aBody.x + aBody.width - aScrollbarWidth, aBody.y, aScrollbarWidth, aBody.height);
+		cv::Rect aRowsArea(aBody.x, aBody.y, aBody.width - aScrollbarWidth, aBody.height);
+
+		// Scroll using the mouse wheel. A wheel notch is usually reported as 120.
+		if (aMouse.wheel != 0 && aRect.contains(aMouse.position)) {
+			int aSteps = aMouse.wheel / 120;
+
+			if (aSteps == 0) {
+				aSteps = aMouse.wheel > 0 ? 1 : -1;
+			}
+
+			theTable->scroll -= aSteps * 3;
+		}
+
+		// Scroll by dragging the scrollbar, centering it on the mouse cursor.
+		if (aHasScrollbar && aMouse.anyButton.pressed && aScrollbar.contains(aMouse.position)) {
+			long long aOffset = (long long)(aMouse.position.y - aScrollbar.y) * theRows / std::max(1, aScrollbar.height);
+			theTable->scroll = (int)aOffset - aFullRows / 2;
+		}
+
+		theTable->scroll = std::max(0, std::min(theTable->scroll, aMaxScroll));
+
+		// Select a row when it is clicked.
+		if (aMouse.anyButton.justReleased && aRowsArea.contains(aMouse.position)) {
+			int aRow = theTable->scroll + (aMouse.position.y - aRowsArea.y) / aRowHeight;
+
+			if (aRow < theRows) {
+				theTable->selected = aRow;
+			}
+		}
+
+		if (theTable->selected >= theRows) {
+			theTable->selected = -1;
+		}
+
+		// Only rows that are visible are formatted (if they are not cached yet) and rendered.
+		internal::tableCache(theTable, theRows, theColumns, aVisibleRows);
+
+		int aLastRow = std::min(theRows, theTable->scroll + aVisibleRows);
+		for (int aRow = theTable->scroll; aRow < aLastRow; aRow++) {
+			internal::tableFormatRow(theTable, aRow, theCell, theData);
+		}
+
+		render::table(theBlock, aRect, aRowsArea, theTable, theHeaders, theColumnWidths, aHeaderHeight, aRowHeight, theFontScale);
+
+		if (aHasScrollbar) {
+			render::tableScrollbar(theBlock, aScrollbar, theTable->scroll, aFullRows, theRows);
 		}
 
 		// Update the layout flow
 		cv::Size aSize(theWidth, theHeight);
 		updateLayoutFlow(theBlock, aSize);
+
+		return theTable->selected;
+	}
+
+	void annotations(cvui_block_t& theBlock, const cvui_annotation_t *theAnnotations, size_t theCount, double theFontScale) {
+		CVUI_PROFILE_ZONE(PROFILE_ANNOTATIONS);
+		internal::widgetId(nullptr, 0, 0);
+
+		cvui_context_t& aContext = internal::getContext();
+		std::vector<cv::Mat>& aLabels = internal::gAnnotationLabels;
+		std::vector<cv::Point>& aPositions = internal::gAnnotationLabelPositions;
+
+		if (aLabels.size() < theCount) {
+			internal::allocation("annotations", theCount * (sizeof(cv::Mat) + sizeof(cv::Point)));
+			aLabels.resize(theCount);
+			aPositions.resize(theCount);
+		}
+
+		// Labels come from the cache of the window, which can't be used by many threads,
+		// so they are all rendered (or found) before the annotations are drawn.
+		for (size_t i = 0; i < theCount; i++) {
+			const cvui_annotation_t& aAnnotation = theAnnotations[i];
+
+			if (aAnnotation.label == nullptr || aAnnotation.label[0] == '\0') {
+				aLabels[i].release();
+				continue;
+			}
+
+			aLabels[i] = internal::annotationLabel(aContext, aAnnotation.label, aAnnotation.color, theFontScale, theBlock.where.type());
+
+			// The label goes above the box, or inside it if there is no room above.
+			int aY = aAnnotation.box.y - aLabels[i].rows;
+			aPositions[i] = cv::Point(aAnnotation.box.x, aY < 0 ? aAnnotation.box.y : aY);
+		}
+
+		render::annotations(theBlock, theAnnotations, aLabels.data(), aPositions.data(), theCount);
+	}
+
+	const cv::Mat& annotationLabel(cvui_context_t& theContext, const char *theLabel, unsigned int theColor, double theFontScale, int theType) {
+		size_t aLength = strlen(theLabel);
+
+		// Rendered labels live in a store of their own, indexed by a hash of their text and style.
+		unsigned int aId = internal::hash(&theColor, sizeof(theColor), gHashSeed);
+		aId = internal::hash(&theType, sizeof(theType), aId);
+		aId = internal::hash(&theFontScale, sizeof(theFontScale), aId);
+
+		// A second hash of the text tells apart different labels whose ids collide.
+		unsigned int aCheck = internal::hash(theLabel, aLength, ~aId);
+		aId = internal::hash(theLabel, aLength, aId);
+
+		aId = aId == 0 ? 1 : aId;
+		cvui_widget_t *aEntry = &internal::widget(theContext.labels, aId, theContext.frame);
+
+		// Labels whose ids collide take the next free ids, so each one keeps its own pixels. Renders
+		// are handed out as shallow copies, thus overwriting the entry of another label would change
+		// the text of that label as well.
+		while (!aEntry->cache.empty() && aEntry->value != aCheck) {
+			aId = aId + 1 == 0 ? 1 : aId + 1;
+			aEntry = &internal::widget(theContext.labels, aId, theContext.frame);
+		}
+
+		cvui_widget_t& aWidget = *aEntry;
+
+		if (aWidget.cache.empty()) {
+			int aBaseline = 0;
+			CVUI_PROFILE_COUNT(PROFILE_TEXT_MEASUREMENTS);
+			cv::Size aTextSize = cv::getTextSize(theLabel, cv::FONT_HERSHEY_SIMPLEX, theFontScale, 1, &aBaseline);
+			cv::Size aSize(aTextSize.width + 4, aTextSize.height + aBaseline + 4);
+
+			internal::allocation(theContext, "annotations", aSize.area() * CV_ELEM_SIZE(theType));
+			aWidget.cache.create(aSize, theType);
+
+			// Dark text on light colors and vice versa, so labels are readable on any color.
+			int aLuma = (((theColor >> 16) & 0xff) * 299 + ((theColor >> 8) & 0xff) * 587 + (theColor & 0xff) * 114) / 1000;
+
+			aWidget.cache.setTo(internal::targetColor(aWidget.cache, internal::hexToScalar(theColor)));
+			CVUI_PROFILE_COUNT(PROFILE_PRIMITIVES);
+			internal::putText(aWidget.cache, theLabel, cv::Point(2, 2 + aTextSize.height), theFontScale, internal::hexToScalar(aLuma > 128 ? 0x000000 : 0xffffff));
+			aWidget.value = aCheck;
+		}
+
+		return aWidget.cache;
+	}
+
+#if defined(CV_SIMD128) && CV_SIMD128
+	// Blends 16 values of a channel of the layer over the same channel of the frame,
+	// exactly like the scalar loop of compositeRows().
+	inline cv::v_uint8x16 compositeLanes(const cv::v_uint8x16& theUi, const cv::v_uint8x16& theFrame, const cv::v_uint8x16& theAlpha) {
+		const cv::v_uint16x8 aMax = cv::v_setall_u16(0xff), aHalf = cv::v_setall_u16(128);
+		cv::v_uint16x8 aUi[2], aFrame[2], aAlpha[2], aResult[2];
+
+		cv::v_expand(theUi, aUi[0], aUi[1]);
+		cv::v_expand(theFrame, aFrame[0], aFrame[1]);
+		cv::v_expand(theAlpha, aAlpha[0], aAlpha[1]);
+
+		// Values fit in 16 bits: frame * (0xff - alpha) + 128 is at most 65153.
+		for (int i = 0; i < 2; i++) {
+#if (CV_MAJOR_VERSION > 4) || (CV_MAJOR_VERSION == 4 && CV_MINOR_VERSION >= 8)
+			cv::v_uint16x8 aValue = cv::v_add(cv::v_mul_wrap(aFrame[i], cv::v_sub(aMax, aAlpha[i])), aHalf);
+			aValue = cv::v_add(aValue, cv::v_shr<8>(aValue));
+			aResult[i] = cv::v_add(aUi[i], cv::v_shr<8>(aValue));
+#else
+			cv::v_uint16x8 aValue = cv::v_mul_wrap(aFrame[i], aMax - aAlpha[i]) + aHalf;
+			aValue = aValue + cv::v_shr<8>(aValue);
+			aResult[i] = aUi[i] + cv::v_shr<8>(aValue);
+#endif
+		}
+
+		// Saturates, like the scalar loop.
+		return cv::v_pack(aResult[0], aResult[1]);
+	}
+#endif
+
+	template<int N>
+	void compositeRows(const cv::Mat& theLayer, const uchar *theLayerRows, const cv::Mat& theFrame, cv::Mat& theOutput, int theStart, int theEnd) {
+		int aWidth = std::min(theLayer.cols, theFrame.cols);
+
+		for (int y = theStart; y < theEnd; y++) {
+			const uchar *aSource = theFrame.ptr<uchar>(y);
+			uchar *aTarget = theOutput.ptr<uchar>(y);
+			int x = 0;
+
+			if (y < theLayer.rows && theLayerRows[y]) {
+				const uchar *aLayer = theLayer.ptr<uchar>(y);
+
+#if defined(CV_SIMD128) && CV_SIMD128
+				// 16 pixels at a time, with the universal intrinsics of OpenCV. Channels are
+				// deinterleaved, so the same code works for frames with 3 and 4 channels.
+				for (; x + 16 <= aWidth; x += 16) {
+					cv::v_uint8x16 aUiB, aUiG, aUiR, aUiA, aB, aG, aR, aA;
+
+					cv::v_load_deinterleave(aLayer + x * 4, aUiB, aUiG, aUiR, aUiA);
+					if (N == 4) {
+						cv::v_load_deinterleave(aSource + x * N, aB, aG, aR, aA);
+					} else {
+						cv::v_load_deinterleave(aSource + x * N, aB, aG, aR);
+					}
+
+					aB = internal::compositeLanes(aUiB, aB, aUiA);
+					aG = internal::compositeLanes(aUiG, aG, aUiA);
+					aR = internal::compositeLanes(aUiR, aR, aUiA);
+
+					// The 4th channel of the frame is kept.
+					if (N == 4) {
+						cv::v_store_interleave(aTarget + x * N, aB, aG, aR, aA);
+					} else {
+						cv::v_store_interleave(aTarget + x * N, aB, aG, aR);
+					}
+				}
+#endif
+
+				// Remaining pixels (all of them without universal intrinsics, e.g. OpenCV 2.x)
+				// are blended in runs of 8. Since colors are premultiplied, the same formula
+				// works for any alpha; runs that are fully transparent are skipped.
+				for (; x + 8 <= aWidth; x += 8) {
+					const uchar *aRun = aLayer + x * 4;
+
+					if ((aRun[3] | aRun[7] | aRun[11] | aRun[15] | aRun[19] | aRun[23] | aRun[27] | aRun[31]) == 0) {
+						// Fully transparent, so the frame shows through.
+						if (aTarget != aSource) {
+							memcpy(aTarget + x * N, aSource + x * N, 8 * N);
+						}
+						continue;
+					}
+
+					for (int i = 0; i < 8; i++) {
+						const uchar *aUi = aRun + i * 4;
+						const uchar *aFrom = aSource + (x + i) * N;
+						uchar *aTo = aTarget + (x + i) * N;
+						unsigned int aAlpha = 0xff - aUi[3];
+
+						for (int c = 0; c < 3; c++) {
+							unsigned int aValue = aFrom[c] * aAlpha + 128;
+							aValue = aUi[c] + ((aValue + (aValue >> 8)) >> 8);
+							aTo[c] = (uchar)(aValue > 0xff ? 0xff : aValue);
+						}
+						if (N == 4) {
+							aTo[N - 1] = aFrom[N - 1];
+						}
+					}
+				}
+
+				for (; x < aWidth; x++) {
+					const uchar *aUi = aLayer + x * 4;
+					unsigned int aAlpha = 0xff - aUi[3];
+
+					for (int c = 0; c < 3; c++) {
+						unsigned int aValue = aSource[x * N + c] * aAlpha + 128;
+						aValue = aUi[c] + ((aValue + (aValue >> 8)) >> 8);
+						aTarget[x * N + c] = (uchar)(aValue > 0xff ? 0xff : aValue);
+					}
+					if (N == 4) {
+						aTarget[x * N + N - 1] = aSource[x * N + N - 1];
+					}
+				}
+			}
+
+			// Whatever is not covered by the layer is the frame itself.
+			if (aTarget != aSource && x < theFrame.cols) {
+				memcpy(aTarget + x * N, aSource + x * N, (theFrame.cols - x) * N);
+			}
+		}
+	}
+
+	// Blends the UI layer over ranges of rows of a frame, see internal::composite().
+	struct CompositeRows : public cv::ParallelLoopBody {
+		cv::Mat layer;
+		const uchar *layerRows;
+		cv::Mat frame;
+		cv::Mat output;
+
+		inline CompositeRows(const cv::Mat& theLayer, const uchar *theLayerRows, const cv::Mat& theFrame, cv::Mat& theOutput)
+			: layer(theLayer), layerRows(theLayerRows), frame(theFrame), output(theOutput) {}
+
+		void operator()(const cv::Range& theRows) const {
+			cv::Mat aOutput = output;
+
+			if (frame.channels() == 3) {
+				internal::compositeRows<3>(layer, layerRows, frame, aOutput, theRows.start, theRows.end);
+			} else {
+				internal::compositeRows<4>(layer, layerRows, frame, aOutput, theRows.start, theRows.end);
+			}
+		}
+	};
+
+	void composite(cvui_context_t& theContext, const cv::Mat& theFrame, cv::Mat& theOutput) {
+		CVUI_TRACE_ZONE(theContext, "composite");
+		cv::Mat& aLayer = theContext.layer;
+		std::vector<uchar>& aRows = theContext.layerRows;
+
+		if (theFrame.type() != CV_8UC3 && theFrame.type() != CV_8UC4) {
+			internal::error(theContext, 10, "The UI layer can only be blended over frames of type CV_8UC3 or CV_8UC4. Convert the frame before showing it, or render the components directly on it.");
+			theFrame.copyTo(theOutput);
+			return;
+		}
+
+		// Rows without components are found once per change of the layer, so they can be skipped.
+		if (aRows.empty()) {
+			internal::allocation(theContext, "layer", aLayer.rows);
+			aRows.assign(aLayer.rows, 0);
+
+			for (int y = 0; y < aLayer.rows; y++) {
+				const uchar *aPixel = aLayer.ptr<uchar>(y);
+
+				for (int x = 0; x < aLayer.cols && !aRows[y]; x++) {
+					aRows[y] = aPixel[x * 4 + 3] != 0;
+				}
+			}
+		}
+
+		if (theOutput.data != theFrame.data) {
+			if (theOutput.size() != theFrame.size() || theOutput.type() != theFrame.type()) {
+				internal::allocation(theContext, "layer", theFrame.total() * theFrame.elemSize());
+			}
+			theOutput.create(theFrame.size(), theFrame.type());
+		}
+
+		CVUI_PROFILE_COUNT(PROFILE_PRIMITIVES);
+		cv::parallel_for_(cv::Range(0, theFrame.rows), CompositeRows(aLayer, aRows.data(), theFrame, theOutput), std::max(1, theFrame.rows / 32));
 	}
 } // namespace internal
 
@@ -1932,48 +4881,73 @@ namespace internal
 namespace render
 {
 	void text(cvui_block_t& theBlock, const cv::String& theText, cv::Point& thePos, double theFontScale, unsigned int theColor) {
-		cv::putText(theBlock.where, theText, thePos, cv::FONT_HERSHEY_SIMPLEX, theFontScale, internal::hexToScalar(theColor), 1, CVUI_ANTIALISED);
+		CVUI_TRACE_ZONE(internal::getContext(), "render::text");
+		CVUI_PROFILE_COUNT(PROFILE_PRIMITIVES);
+		internal::putText(theBlock.where, theText, thePos, theFontScale, internal::hexToScalar(theColor));
 	}
 
 	void button(cvui_block_t& theBlock, int theState, cv::Rect& theShape, double theFontScale, unsigned int theInsideColor) {
-		unsigned int brightColor = internal::brightenColor(theInsideColor, 0x505050);
-		unsigned int darkColor = internal::darkenColor(theInsideColor, 0x505050);
-		unsigned int topLeftColor, bottomRightColor;
+		CVUI_TRACE_ZONE(internal::getContext(), "render::button");
+		// A skin replaces the 3D outline and the inside of the button.
+		if (internal::skin(theBlock.where, SKIN_BUTTON, theState, theShape)) {
+			return;
+		}
+
+		const cvui_theme_t& aTheme = internal::theme();
+		cv::Scalar aBright, aDark, aInside, aTopLeft, aBottomRight;
+
+		// Buttons with the color of the theme use its precomputed colors, the others compute their own.
+		if (theInsideColor == aTheme.colors[THEME_BUTTON]) {
+			aBright = aTheme.scalars[THEME_BUTTON_BRIGHT];
+			aDark = aTheme.scalars[THEME_BUTTON_DARK];
+			aInside = aTheme.scalars[theState == OUT ? THEME_BUTTON : (theState == OVER ? THEME_BUTTON_OVER : THEME_BUTTON_DOWN)];
+		} else {
+			unsigned int aHighlight = aTheme.colors[THEME_BUTTON_HIGHLIGHT];
+			aBright = internal::hexToScalar(internal::brightenColor(theInsideColor, aTheme.colors[THEME_BUTTON_BEVEL]));
+			aDark = internal::hexToScalar(internal::darkenColor(theInsideColor, aTheme.colors[THEME_BUTTON_BEVEL]));
+			aInside = internal::hexToScalar(theState == OUT ? theInsideColor : (theState == OVER ? internal::brightenColor(theInsideColor, aHighlight) : internal::darkenColor(theInsideColor, aHighlight)));
+		}
+
 		// 3D effect depending on if the button is down or up. Light comes from top left.
 		if (theState == OVER || theState == OUT) // button is up
 		{
-			topLeftColor = brightColor;
-			bottomRightColor = darkColor;
+			aTopLeft = aBright;
+			aBottomRight = aDark;
 		}
 		else // button is down
 		{
-			bottomRightColor = brightColor;
-			topLeftColor = darkColor;
+			aBottomRight = aBright;
+			aTopLeft = aDark;
 		}
 
-		unsigned int insideOverColor  = internal::brightenColor(theInsideColor, 0x101010); // particularly this is 0x525252 for DEFAULT_BUTTON_COLOR 0x424242
-		unsigned int insideOtherColor = internal::darkenColor(theInsideColor, 0x101010); // particularly this is 0x323232 for DEFAULT_BUTTON_COLOR 0x424242
-
-		// 3D Outline. Note that cv::rectangle exludes theShape.br(), so we have to also exclude this point when drawing lines with cv::line
+		// 3D Outline. Note that cv::rectangle exludes theShape.br(), so we have to also exclude this point when drawing lines
 		unsigned int thicknessOf3DOutline = (int)(theFontScale / 0.6); // On high DPI displayed we need to make the border thicker. We scale it together with the font size the user chose.
 		do
 		{
-			cv::line(theBlock.where, theShape.br() - cv::Point(1, 1), cv::Point(theShape.tl().x, theShape.br().y - 1), internal::hexToScalar(bottomRightColor));
-			cv::line(theBlock.where, theShape.br() - cv::Point(1, 1), cv::Point(theShape.br().x - 1, theShape.tl().y), internal::hexToScalar(bottomRightColor));
-			cv::line(theBlock.where, theShape.tl(), cv::Point(theShape.tl().x, theShape.br().y - 1), internal::hexToScalar(topLeftColor));
-			cv::line(theBlock.where, theShape.tl(), cv::Point(theShape.br().x - 1, theShape.tl().y), internal::hexToScalar(topLeftColor));
+			CVUI_PROFILE_COUNT(PROFILE_PRIMITIVES);
+			internal::line(theBlock.where, theShape.br() - cv::Point(1, 1), cv::Point(theShape.tl().x, theShape.br().y - 1), aBottomRight);
+			CVUI_PROFILE_COUNT(PROFILE_PRIMITIVES);
+			internal::line(theBlock.where, theShape.br() - cv::Point(1, 1), cv::Point(theShape.br().x - 1, theShape.tl().y), aBottomRight);
+			CVUI_PROFILE_COUNT(PROFILE_PRIMITIVES);
+			internal::line(theBlock.where, theShape.tl(), cv::Point(theShape.tl().x, theShape.br().y - 1), aTopLeft);
+			CVUI_PROFILE_COUNT(PROFILE_PRIMITIVES);
+			internal::line(theBlock.where, theShape.tl(), cv::Point(theShape.br().x - 1, theShape.tl().y), aTopLeft);
 			theShape.x++; theShape.y++; theShape.width -= 2; theShape.height -= 2;
 		} while (thicknessOf3DOutline--); // we want at least 1 pixel 3D outline, even for very small fonts
 
-		cv::rectangle(theBlock.where, theShape, theState == OUT ? internal::hexToScalar(theInsideColor) : (theState == OVER ? internal::hexToScalar(insideOverColor) : internal::hexToScalar(insideOtherColor)), CVUI_FILLED);
+		CVUI_PROFILE_COUNT(PROFILE_PRIMITIVES);
+		internal::rectangle(theBlock.where, theShape, aInside, CVUI_FILLED);
 	}
 
 	int putText(cvui_block_t& theBlock, int theState, cv::Scalar aColor, const std::string& theText, const cv::Point& thePosition, double theFontScale) {
+		CVUI_TRACE_ZONE(internal::getContext(), "render::putText");
 		double aFontSize = theState == cvui::DOWN ? theFontScale-0.01 : theFontScale;
 		cv::Size aSize;
 
 		if (theText != "") {
-			cv::putText(theBlock.where, theText, thePosition, cv::FONT_HERSHEY_SIMPLEX, aFontSize, aColor, 1, CVUI_ANTIALISED);
+			CVUI_PROFILE_COUNT(PROFILE_PRIMITIVES);
+			internal::putText(theBlock.where, theText, thePosition, aFontSize, aColor);
+			CVUI_PROFILE_COUNT(PROFILE_TEXT_MEASUREMENTS);
 			aSize = cv::getTextSize(theText, cv::FONT_HERSHEY_SIMPLEX, aFontSize, 1, nullptr);
 		}
 
@@ -1981,19 +4955,27 @@ namespace render
 	}
 
 	int putTextCentered(cvui_block_t& theBlock, const cv::Point & position, const std::string &text, double theFontScale) {
+		CVUI_TRACE_ZONE(internal::getContext(), "render::putTextCentered");
+		CVUI_PROFILE_COUNT(PROFILE_TEXT_MEASUREMENTS);
 		auto size = cv::getTextSize(text, cv::FONT_HERSHEY_SIMPLEX, theFontScale, 1, nullptr);
 		cv::Point positionDecentered(position.x - size.width / 2, position.y);
-		cv::putText(theBlock.where, text, positionDecentered, cv::FONT_HERSHEY_SIMPLEX, theFontScale, cv::Scalar(0xCE, 0xCE, 0xCE), 1, CVUI_ANTIALISED);
+		CVUI_PROFILE_COUNT(PROFILE_PRIMITIVES);
+		internal::putText(theBlock.where, text, positionDecentered, theFontScale, internal::theme().scalars[THEME_TEXT]);
 
 		return size.width;
 	}
 
 	void buttonLabel(cvui_block_t& theBlock, int theState, cv::Rect theRect, const cv::String& theLabel, cv::Size& theTextSize, double theFontScale, unsigned int theInsideColor) {
+		CVUI_TRACE_ZONE(internal::getContext(), "render::buttonLabel");
 		cv::Point aPos(theRect.x + theRect.width / 2 - theTextSize.width / 2, theRect.y + theRect.height / 2 + theTextSize.height / 2);
-		const bool buttonIsDark = internal::brightnessOfColor(theInsideColor) < 0x80; 
-		cv::Scalar aColor = buttonIsDark ? cv::Scalar(0xCE, 0xCE, 0xCE) : cv::Scalar(0x32, 0x32, 0x32);
+		const cvui_theme_t& aTheme = internal::theme();
+		cv::Scalar aColor = aTheme.scalars[THEME_BUTTON_LABEL];
 
-		auto aLabel = internal::createLabel(theLabel);
+		if (theInsideColor != aTheme.colors[THEME_BUTTON]) {
+			aColor = aTheme.scalars[internal::brightnessOfColor(theInsideColor) < 0x80 ? THEME_TEXT : THEME_TEXT_DARK];
+		}
+
+		const cvui_label_t& aLabel = internal::createLabel(theLabel);
 
 		if (!aLabel.hasShortcut) {
 			putText(theBlock, theState, aColor, theLabel, aPos, theFontScale);
@@ -2011,28 +4993,46 @@ namespace render
 			aPos.x += aWidth;
 
 			putText(theBlock, theState, aColor, aLabel.textAfterShortcut, aPos, theFontScale);
-			cv::line(theBlock.where, cv::Point(aStart, aPos.y + 3), cv::Point(aEnd, aPos.y + 3), aColor, 1, CVUI_ANTIALISED);
+			CVUI_PROFILE_COUNT(PROFILE_PRIMITIVES);
+			cv::line(theBlock.where, cv::Point(aStart, aPos.y + 3), cv::Point(aEnd, aPos.y + 3), internal::targetColor(theBlock.where, aColor), 1, CVUI_ANTIALISED);
 		}
 	}
 
 	void image(cvui_block_t& theBlock, cv::Rect& theRect, cv::Mat& theImage) {
-		theImage.copyTo(theBlock.where(theRect));
+		CVUI_TRACE_ZONE(internal::getContext(), "render::image");
+		CVUI_PROFILE_COUNT(PROFILE_PRIMITIVES);
+		cv::Mat aTarget = theBlock.where(theRect);
+
+		// Images of another type, e.g. a color image on a grayscale frame, are converted while they are copied.
+		if (theImage.type() == aTarget.type()) {
+			theImage.copyTo(aTarget);
+		} else {
+			internal::convertImage(theImage, aTarget);
+		}
 	}
 
 	void counter(cvui_block_t& theBlock, cv::Rect& theShape, const cv::String& theValue, double theFontScale) {
-		cv::rectangle(theBlock.where, theShape, cv::Scalar(0x29, 0x29, 0x29), CVUI_FILLED); // fill
-		cv::rectangle(theBlock.where, theShape, cv::Scalar(0x45, 0x45, 0x45)); // border
-
+		CVUI_TRACE_ZONE(internal::getContext(), "render::counter");
+		const cvui_theme_t& aTheme = internal::theme();
+		CVUI_PROFILE_COUNT(PROFILE_PRIMITIVES);
+		internal::rectangle(theBlock.where, theShape, aTheme.scalars[THEME_COUNTER], CVUI_FILLED); // fill
+		CVUI_PROFILE_COUNT(PROFILE_PRIMITIVES);
+		internal::rectangle(theBlock.where, theShape, aTheme.scalars[THEME_COUNTER_BORDER], 1); // border
+
+		CVUI_PROFILE_COUNT(PROFILE_TEXT_MEASUREMENTS);
 		cv::Size aTextSize = getTextSize(theValue, cv::FONT_HERSHEY_SIMPLEX, theFontScale, 1, nullptr);
 
 		cv::Point aPos(theShape.x + theShape.width / 2 - aTextSize.width / 2, theShape.y + aTextSize.height / 2 + theShape.height / 2);
-		cv::putText(theBlock.where, theValue, aPos, cv::FONT_HERSHEY_SIMPLEX, theFontScale, cv::Scalar(0xCE, 0xCE, 0xCE), 1, CVUI_ANTIALISED);
+		CVUI_PROFILE_COUNT(PROFILE_PRIMITIVES);
+		internal::putText(theBlock.where, theValue, aPos, theFontScale, aTheme.scalars[THEME_TEXT]);
 	}
 
 	void trackbarHandle(cvui_block_t& theBlock, int theState, cv::Rect& theShape, double theValue, const internal::TrackbarParams &theParams, cv::Rect& theWorkingArea) {
+		CVUI_TRACE_ZONE(internal::getContext(), "render::trackbarHandle");
+		const cvui_theme_t& aTheme = internal::theme();
 		const double scale = theParams.fontScale/DEFAULT_FONT_SCALE;
 		cv::Point aBarTopLeft(theWorkingArea.x, theWorkingArea.y + theWorkingArea.height / 2);
-		int aBarHeight = 7;
+		int aBarHeight = aTheme.trackbarHeight;
 
 		// Draw the rectangle representing the handle
 		int aPixelX = internal::trackbarValueToXPixel(theParams, theShape, theValue);
@@ -2042,11 +5042,11 @@ namespace render
 		cv::Point aPoint2(aPixelX + aIndicatorWidth, aBarTopLeft.y + aBarHeight + aIndicatorHeight);
 		cv::Rect aRect(aPoint1, aPoint2);
 
-		int aFillColor = theState == OVER ? 0x525252 : 0x424242;
-
-		rect(theBlock, aRect, 0x212121, 0x212121);
-		aRect.x += 1; aRect.y += 1; aRect.width -= 2; aRect.height -= 2;
-		rect(theBlock, aRect, 0x515151, aFillColor);
+		if (!internal::skin(theBlock.where, SKIN_TRACKBAR_HANDLE, theState, aRect)) {
+			rect(theBlock, aRect, aTheme.scalars[THEME_TRACKBAR_HANDLE_BORDER], aTheme.scalars[THEME_TRACKBAR_HANDLE_BORDER]);
+			aRect.x += 1; aRect.y += 1; aRect.width -= 2; aRect.height -= 2;
+			rect(theBlock, aRect, aTheme.scalars[THEME_TRACKBAR_HANDLE_OUTLINE], aTheme.scalars[theState == OVER ? THEME_TRACKBAR_HANDLE_OVER : THEME_TRACKBAR_HANDLE]);
+		}
 
 		bool aShowLabel = internal::bitsetHas(theParams.options, cvui::TRACKBAR_HIDE_VALUE_LABEL) == false;
 
@@ -2054,24 +5054,30 @@ namespace render
 		if (aShowLabel) {
 			cv::Point aTextPos(aPixelX, aPoint2.y + std::lround(11*scale));
 			sprintf_s(internal::gBuffer, theParams.labelFormat.c_str(), static_cast<long double>(theValue));
-			putTextCentered(theBlock, aTextPos, internal::gBuffer, theParams.fontScale-0.1);
+			putTextCentered(theBlock, aTextPos, internal::bufferText(), theParams.fontScale-0.1);
 		}
 	}
 
 	void trackbarPath(cvui_block_t& theBlock, int theState, cv::Rect& theWorkingArea) {
-		int aBarHeight = 7;
+		CVUI_TRACE_ZONE(internal::getContext(), "render::trackbarPath");
+		const cvui_theme_t& aTheme = internal::theme();
+		int aBarHeight = aTheme.trackbarHeight;
 		cv::Point aBarTopLeft(theWorkingArea.x, theWorkingArea.y + theWorkingArea.height / 2);
 		cv::Rect aRect(aBarTopLeft, cv::Size(theWorkingArea.width, aBarHeight));
 
-		int aBorderColor = theState == OVER ? 0x4e4e4e : 0x3e3e3e;
+		if (internal::skin(theBlock.where, SKIN_TRACKBAR, theState, aRect)) {
+			return;
+		}
 
-		rect(theBlock, aRect, aBorderColor, 0x292929);
-		cv::line(theBlock.where, cv::Point(aRect.x + 1, aRect.y + aBarHeight - 2), cv::Point(aRect.x + aRect.width - 2, aRect.y + aBarHeight - 2), cv::Scalar(0x0e, 0x0e, 0x0e));
+		rect(theBlock, aRect, aTheme.scalars[theState == OVER ? THEME_TRACKBAR_BORDER_OVER : THEME_TRACKBAR_BORDER], aTheme.scalars[THEME_TRACKBAR]);
+		CVUI_PROFILE_COUNT(PROFILE_PRIMITIVES);
+		internal::line(theBlock.where, cv::Point(aRect.x + 1, aRect.y + aBarHeight - 2), cv::Point(aRect.x + aRect.width - 2, aRect.y + aBarHeight - 2), aTheme.scalars[THEME_TRACKBAR_SHADOW]);
 	}
 
 	void trackbarSteps(cvui_block_t& theBlock, cv::Rect& theShape, const internal::TrackbarParams &theParams, cv::Rect& theWorkingArea) {
+		CVUI_TRACE_ZONE(internal::getContext(), "render::trackbarSteps");
 		cv::Point aBarTopLeft(theWorkingArea.x, theWorkingArea.y + theWorkingArea.height / 2);
-		cv::Scalar aColor(0x51, 0x51, 0x51);
+		const cv::Scalar& aColor = internal::theme().scalars[THEME_TRACKBAR_STEPS];
 
 		bool aDiscrete = internal::bitsetHas(theParams.options, cvui::TRACKBAR_DISCRETE);
 		long double aFixedStep = aDiscrete ? theParams.step : (theParams.max - theParams.min) / 20;
@@ -2081,29 +5087,33 @@ namespace render
 			int aPixelX = internal::trackbarValueToXPixel(theParams, theShape, aValue);
 			cv::Point aPoint1(aPixelX, aBarTopLeft.y);
 			cv::Point aPoint2(aPixelX, aBarTopLeft.y - 3);
-			cv::line(theBlock.where, aPoint1, aPoint2, aColor);
+			CVUI_PROFILE_COUNT(PROFILE_PRIMITIVES);
+			internal::line(theBlock.where, aPoint1, aPoint2, aColor);
 		}
 	}
 
 	void trackbarSegmentLabel(cvui_block_t& theBlock, cv::Rect& theShape, const internal::TrackbarParams &theParams, long double theValue, cv::Rect& theWorkingArea, bool theShowLabel) {
-		cv::Scalar aColor(0x51, 0x51, 0x51);
+		CVUI_TRACE_ZONE(internal::getContext(), "render::trackbarSegmentLabel");
+		const cv::Scalar& aColor = internal::theme().scalars[THEME_TRACKBAR_STEPS];
 		cv::Point aBarTopLeft(theWorkingArea.x, theWorkingArea.y + theWorkingArea.height / 2);
 
 		int aPixelX = internal::trackbarValueToXPixel(theParams, theShape, theValue);
 
 		cv::Point aPoint1(aPixelX, aBarTopLeft.y);
 		cv::Point aPoint2(aPixelX, aBarTopLeft.y - std::lround(8*theParams.fontScale/DEFAULT_FONT_SCALE));
-		cv::line(theBlock.where, aPoint1, aPoint2, aColor);
+		CVUI_PROFILE_COUNT(PROFILE_PRIMITIVES);
+		internal::line(theBlock.where, aPoint1, aPoint2, aColor);
 
 		if (theShowLabel)
 		{
 			sprintf_s(internal::gBuffer, theParams.labelFormat.c_str(), theValue);
 			cv::Point aTextPos(aPixelX, aBarTopLeft.y - std::lround(11*theParams.fontScale/DEFAULT_FONT_SCALE));
-			putTextCentered(theBlock, aTextPos, internal::gBuffer, theParams.fontScale-0.1);
+			putTextCentered(theBlock, aTextPos, internal::bufferText(), theParams.fontScale-0.1);
 		}
   }
 
 	void trackbarSegments(cvui_block_t& theBlock, cv::Rect& theShape, const internal::TrackbarParams &theParams, cv::Rect& theWorkingArea) {
+		CVUI_TRACE_ZONE(internal::getContext(), "render::trackbarSegments");
 		int aSegments = theParams.segments < 1 ? 1 : theParams.segments;
 		long double aSegmentLength = (long double)(theParams.max - theParams.min) / (long double)aSegments;
 
@@ -2124,6 +5134,7 @@ namespace render
 	}
 
 	void trackbar(cvui_block_t& theBlock, int theState, cv::Rect& theShape, double theValue, const internal::TrackbarParams &theParams) {
+		CVUI_TRACE_ZONE(internal::getContext(), "render::trackbar");
 		cv::Rect aWorkingArea(theShape.x + internal::gTrackbarMarginX, theShape.y, theShape.width - 2 * internal::gTrackbarMarginX, theShape.height);
 
 		trackbarPath(theBlock, theState, aWorkingArea);
@@ -2143,87 +5154,131 @@ namespace render
 	}
 
 	void checkbox(cvui_block_t& theBlock, int theState, cv::Rect& theShape) {
+		CVUI_TRACE_ZONE(internal::getContext(), "render::checkbox");
+		const cvui_theme_t& aTheme = internal::theme();
 		// Outline
-		cv::rectangle(theBlock.where, theShape, theState == OUT ? cv::Scalar(0x63, 0x63, 0x63) : cv::Scalar(0x80, 0x80, 0x80));
+		CVUI_PROFILE_COUNT(PROFILE_PRIMITIVES);
+		internal::rectangle(theBlock.where, theShape, aTheme.scalars[theState == OUT ? THEME_CHECKBOX_OUTLINE : THEME_CHECKBOX_OUTLINE_OVER], 1);
 
 		// Border
 		theShape.x++; theShape.y++; theShape.width -= 2; theShape.height -= 2;
-		cv::rectangle(theBlock.where, theShape, cv::Scalar(0x17, 0x17, 0x17));
+		CVUI_PROFILE_COUNT(PROFILE_PRIMITIVES);
+		internal::rectangle(theBlock.where, theShape, aTheme.scalars[THEME_CHECKBOX_BORDER], 1);
 
 		// Inside
 		theShape.x++; theShape.y++; theShape.width -= 2; theShape.height -= 2;
-		cv::rectangle(theBlock.where, theShape, cv::Scalar(0x29, 0x29, 0x29), CVUI_FILLED);
+		CVUI_PROFILE_COUNT(PROFILE_PRIMITIVES);
+		internal::rectangle(theBlock.where, theShape, aTheme.scalars[THEME_CHECKBOX], CVUI_FILLED);
 	}
 
 	void checkboxLabel(cvui_block_t& theBlock, cv::Rect& theRect, const cv::String& theLabel, cv::Size& theTextSize, unsigned int theColor, double theFontScale) {
+		CVUI_TRACE_ZONE(internal::getContext(), "render::checkboxLabel");
 		cv::Point aPos(theRect.x + theRect.width + 6, theRect.y + theTextSize.height + theRect.height / 2 - theTextSize.height / 2 - 1);
 		text(theBlock, theLabel, aPos, theFontScale, theColor);
 	}
 
 	void checkboxCheck(cvui_block_t& theBlock, cv::Rect& theShape) {
+		CVUI_TRACE_ZONE(internal::getContext(), "render::checkboxCheck");
 		theShape.x++; theShape.y++; theShape.width -= 2; theShape.height -= 2;
-		cv::rectangle(theBlock.where, theShape, cv::Scalar(0xFF, 0xBF, 0x75), CVUI_FILLED);
+		CVUI_PROFILE_COUNT(PROFILE_PRIMITIVES);
+		internal::rectangle(theBlock.where, theShape, internal::theme().scalars[THEME_CHECKBOX_CHECK], CVUI_FILLED);
 	}
 
 	void window(cvui_block_t& theBlock, cv::Rect& theTitleBar, cv::Rect& theContent, const cv::String& theTitle, double theFontScale) {
+		CVUI_TRACE_ZONE(internal::getContext(), "render::window");
+		const cvui_theme_t& aTheme = internal::theme();
 		bool aTransparecy = false;
 		double aAlpha = 0.3;
-		cv::Mat aOverlay;
 
-		// Render the title bar.
-		// First the border
-		cv::rectangle(theBlock.where, theTitleBar, cv::Scalar(0x4A, 0x4A, 0x4A));
+		// Render the title bar, unless it has a skin.
+		bool aTitleSkinned = internal::skin(theBlock.where, SKIN_WINDOW_TITLE, OUT, theTitleBar);
+
+		if (!aTitleSkinned) {
+			// First the border
+			CVUI_PROFILE_COUNT(PROFILE_PRIMITIVES);
+			internal::rectangle(theBlock.where, theTitleBar, aTheme.scalars[THEME_WINDOW_BORDER], 1);
+		}
 		// then the inside
 		theTitleBar.x++; theTitleBar.y++; theTitleBar.width -= 2; theTitleBar.height -= 2;
-		cv::rectangle(theBlock.where, theTitleBar, cv::Scalar(0x21, 0x21, 0x21), CVUI_FILLED);
+		if (!aTitleSkinned) {
+			CVUI_PROFILE_COUNT(PROFILE_PRIMITIVES);
+			internal::rectangle(theBlock.where, theTitleBar, aTheme.scalars[THEME_WINDOW_TITLE], CVUI_FILLED);
+		}
 
 		// Render title text.
 		cv::Point aPos(theTitleBar.x + 5, theTitleBar.y + std::lround(12 * theFontScale/DEFAULT_FONT_SCALE));
-		cv::putText(theBlock.where, theTitle, aPos, cv::FONT_HERSHEY_SIMPLEX, theFontScale, cv::Scalar(0xCE, 0xCE, 0xCE), 1, CVUI_ANTIALISED);
+		CVUI_PROFILE_COUNT(PROFILE_PRIMITIVES);
+		internal::putText(theBlock.where, theTitle, aPos, theFontScale, aTheme.scalars[THEME_TEXT]);
+
+		// Render the body, unless it has a skin.
+		if (internal::skin(theBlock.where, SKIN_WINDOW, OUT, theContent)) {
+			return;
+		}
 
-		// Render the body.
 		// First the border.
-		cv::rectangle(theBlock.where, theContent, cv::Scalar(0x4A, 0x4A, 0x4A));
+		CVUI_PROFILE_COUNT(PROFILE_PRIMITIVES);
+		internal::rectangle(theBlock.where, theContent, aTheme.scalars[THEME_WINDOW_BORDER], 1);
 
 		// Then the filling.
 		theContent.x++; theContent.y++; theContent.width -= 2; theContent.height -= 2;
-		cv::rectangle(theBlock.where, theContent, cv::Scalar(0x31, 0x31, 0x31), CVUI_FILLED);
+		CVUI_PROFILE_COUNT(PROFILE_PRIMITIVES);
+		internal::rectangle(theBlock.where, theContent, aTheme.scalars[THEME_WINDOW], CVUI_FILLED);
 
 		if (aTransparecy) {
-			theBlock.where.copyTo(aOverlay);
-			cv::rectangle(aOverlay, theContent, cv::Scalar(0x31, 0x31, 0x31), CVUI_FILLED);
-			cv::addWeighted(aOverlay, aAlpha, theBlock.where, 1.0 - aAlpha, 0.0, theBlock.where);
-
+			// Only the content changes, so only the content is blended.
+			cv::Rect aClippedRect = theContent & cv::Rect(cv::Point(0, 0), theBlock.where.size());
+
+			if (aClippedRect.area() > 0) {
+				cv::Mat aOverlay = internal::scratch(aClippedRect.size(), theBlock.where.type());
+				CVUI_PROFILE_COUNT(PROFILE_PRIMITIVES);
+				aOverlay.setTo(internal::targetColor(aOverlay, aTheme.scalars[THEME_WINDOW]));
+				CVUI_PROFILE_COUNT(PROFILE_PRIMITIVES);
+				cv::addWeighted(aOverlay, aAlpha, theBlock.where(aClippedRect), 1.0 - aAlpha, 0.0, theBlock.where(aClippedRect));
+			}
 		}
 		else {
-			cv::rectangle(theBlock.where, theContent, cv::Scalar(0x31, 0x31, 0x31), CVUI_FILLED);
+			CVUI_PROFILE_COUNT(PROFILE_PRIMITIVES);
+			internal::rectangle(theBlock.where, theContent, aTheme.scalars[THEME_WINDOW], CVUI_FILLED);
 		}
 	}
 
 	void rect(cvui_block_t& theBlock, cv::Rect& thePos, unsigned int theBorderColor, unsigned int theFillingColor) {
-		cv::Scalar aBorder = internal::hexToScalar(theBorderColor);
-		cv::Scalar aFilling = internal::hexToScalar(theFillingColor);
+		rect(theBlock, thePos, internal::hexToScalar(theBorderColor), internal::hexToScalar(theFillingColor));
+	}
 
-		bool aHasFilling = aFilling[3] != 0xff;
+	void rect(cvui_block_t& theBlock, cv::Rect& thePos, const cv::Scalar& theBorderColor, const cv::Scalar& theFillingColor) {
+		CVUI_TRACE_ZONE(internal::getContext(), "render::rect");
+		cv::Scalar aFilling = internal::targetColor(theBlock.where, theFillingColor);
+		bool aHasFilling = theFillingColor[3] != 0xff;
+		cv::Rect aClippedRect = thePos & cv::Rect(cv::Point(0, 0), theBlock.where.size());
 
 		if (aHasFilling) {
-			if (aFilling[3] == 0x00) {
+			if (theFillingColor[3] == 0x00) {
 				// full opacity
+				CVUI_PROFILE_COUNT(PROFILE_PRIMITIVES);
 				cv::rectangle(theBlock.where, thePos, aFilling, CVUI_FILLED, CVUI_ANTIALISED);
 			}
-			else {
-				cv::Rect aClippedRect = thePos & cv::Rect(cv::Point(0, 0), theBlock.where.size());
-				double aAlpha = 1.00 - static_cast<double>(aFilling[3]) / 255;
-				cv::Mat aOverlay(aClippedRect.size(), theBlock.where.type(), aFilling);
+			else if (aClippedRect.area() > 0) {
+				// The overlay lives in a scratch buffer, so translucent rects do not allocate memory.
+				double aAlpha = 1.00 - static_cast<double>(theFillingColor[3]) / 255;
+				cv::Mat aOverlay = internal::scratch(aClippedRect.size(), theBlock.where.type());
+
+				// The overlay is opaque, otherwise its transparency would be blended into the
+				// alpha channel of the target (e.g. a UI layer) along with its color.
+				aFilling = internal::targetColor(theBlock.where, cv::Scalar(theFillingColor[0], theFillingColor[1], theFillingColor[2], 0));
+				aOverlay.setTo(aFilling);
+				CVUI_PROFILE_COUNT(PROFILE_PRIMITIVES);
 				cv::addWeighted(aOverlay, aAlpha, theBlock.where(aClippedRect), 1.00 - aAlpha, 0.0, theBlock.where(aClippedRect));
 			}
 		}
 
 		// Render the border
-		cv::rectangle(theBlock.where, thePos, aBorder, 1, CVUI_ANTIALISED);
+		CVUI_PROFILE_COUNT(PROFILE_PRIMITIVES);
+		cv::rectangle(theBlock.where, thePos, internal::targetColor(theBlock.where, theBorderColor), 1, CVUI_ANTIALISED);
 	}
 
 	void sparkline(cvui_block_t& theBlock, std::vector<double>& theValues, cv::Rect &theRect, double theMin, double theMax, unsigned int theColor) {
+		CVUI_TRACE_ZONE(internal::getContext(), "render::sparkline");
 		std::vector<double>::size_type aSize = theValues.size(), i;
 		double aGap, aPosX, aScale = 0, x, y;
 
@@ -2236,120 +5291,412 @@ namespace render
 			y = (theValues[i] - theMin) / aScale * -(theRect.height - 5) + theRect.y + theRect.height - 5;
 			cv::Point aPoint1((int)x, (int)y);
 
-			x = aPosX + aGap;
-			y = (theValues[i + 1] - theMin) / aScale * -(theRect.height - 5) + theRect.y + theRect.height - 5;
-			cv::Point aPoint2((int)x, (int)y);
+			x = aPosX + aGap;
+			y = (theValues[i + 1] - theMin) / aScale * -(theRect.height - 5) + theRect.y + theRect.height - 5;
+			cv::Point aPoint2((int)x, (int)y);
+
+			CVUI_PROFILE_COUNT(PROFILE_PRIMITIVES);
+			internal::line(theBlock.where, aPoint1, aPoint2, internal::hexToScalar(theColor));
+			aPosX += aGap;
+		}
+	}
+
+	void tableCell(cvui_block_t& theBlock, cv::Rect theCell, const cv::String& theText, int theBaseline, double theFontScale) {
+		CVUI_TRACE_ZONE(internal::getContext(), "render::tableCell");
+		// Text is rendered into a sub-image of the cell, so it is clipped
+		// by the cell instead of overflowing into the next column.
+		cv::Rect aClipped = theCell & cv::Rect(0, 0, theBlock.where.cols, theBlock.where.rows);
+
+		if (aClipped.area() > 0 && !theText.empty()) {
+			cv::Mat aCell = theBlock.where(aClipped);
+			cv::Point aPos(theCell.x - aClipped.x + 4, theCell.y - aClipped.y + theBaseline);
+			CVUI_PROFILE_COUNT(PROFILE_PRIMITIVES);
+			internal::putText(aCell, theText, aPos, theFontScale, internal::theme().scalars[THEME_TEXT]);
+		}
+	}
+
+	void table(cvui_block_t& theBlock, cv::Rect& theShape, cv::Rect& theRowsArea, cvui_table_t *theTable, const cv::String theHeaders[], const int theColumnWidths[], int theHeaderHeight, int theRowHeight, double theFontScale) {
+		CVUI_TRACE_ZONE(internal::getContext(), "render::table");
+		const cvui_theme_t& aTheme = internal::theme();
+		CVUI_PROFILE_COUNT(PROFILE_TEXT_MEASUREMENTS);
+		cv::Size aTextSize = cv::getTextSize("0", cv::FONT_HERSHEY_SIMPLEX, theFontScale, 1, nullptr);
+		int aBaseline = theRowHeight / 2 + aTextSize.height / 2;
+		int aRight = theRowsArea.x + theRowsArea.width;
+		int aBottom = theRowsArea.y + theRowsArea.height;
+
+		// Body
+		CVUI_PROFILE_COUNT(PROFILE_PRIMITIVES);
+		internal::rectangle(theBlock.where, theShape, aTheme.scalars[THEME_TABLE], CVUI_FILLED);
+
+		// Header
+		if (theHeaderHeight > 0) {
+			cv::Rect aHeader(theShape.x, theShape.y, theShape.width, theHeaderHeight);
+			CVUI_PROFILE_COUNT(PROFILE_PRIMITIVES);
+			internal::rectangle(theBlock.where, aHeader, aTheme.scalars[THEME_TABLE_HEADER], CVUI_FILLED);
+
+			for (int c = 0, aX = aHeader.x; c < theTable->columns && aX < aRight; aX += theColumnWidths[c], c++) {
+				cv::Rect aCell(aX, aHeader.y, std::min(theColumnWidths[c], aRight - aX), aHeader.height);
+				tableCell(theBlock, aCell, theHeaders[c], aBaseline, theFontScale);
+			}
+		}
+
+		// Visible rows, whose text was already formatted and cached.
+		for (int aRow = theTable->scroll, aY = theRowsArea.y; aRow < theTable->rows && aY < aBottom; aRow++, aY += theRowHeight) {
+			cv::Rect aLine(theRowsArea.x, aY, theRowsArea.width, std::min(theRowHeight, aBottom - aY));
+			int aSlot = aRow % theTable->capacity;
+
+			if (aRow == theTable->selected) {
+				CVUI_PROFILE_COUNT(PROFILE_PRIMITIVES);
+				internal::rectangle(theBlock.where, aLine, aTheme.scalars[THEME_TABLE_SELECTION], CVUI_FILLED);
+			}
+
+			for (int c = 0, aX = aLine.x; c < theTable->columns && aX < aRight; aX += theColumnWidths[c], c++) {
+				cv::Rect aCell(aX, aLine.y, std::min(theColumnWidths[c], aRight - aX), aLine.height);
+				tableCell(theBlock, aCell, theTable->cells[aSlot * theTable->columns + c], aBaseline, theFontScale);
+			}
+		}
+
+		// Column separators
+		for (int c = 0, aX = theShape.x; c < theTable->columns - 1; c++) {
+			aX += theColumnWidths[c];
+
+			if (aX >= aRight) {
+				break;
+			}
+
+			CVUI_PROFILE_COUNT(PROFILE_PRIMITIVES);
+			internal::line(theBlock.where, cv::Point(aX, theShape.y), cv::Point(aX, aBottom - 1), aTheme.scalars[THEME_TABLE_SEPARATOR]);
+		}
+
+		// Border
+		CVUI_PROFILE_COUNT(PROFILE_PRIMITIVES);
+		internal::rectangle(theBlock.where, theShape, aTheme.scalars[THEME_TABLE_BORDER], 1);
+
+		if (theHeaderHeight > 0) {
+			CVUI_PROFILE_COUNT(PROFILE_PRIMITIVES);
+			internal::line(theBlock.where, cv::Point(theShape.x, theRowsArea.y), cv::Point(theShape.x + theShape.width - 1, theRowsArea.y), aTheme.scalars[THEME_TABLE_BORDER]);
+		}
+	}
+
+	void tableScrollbar(cvui_block_t& theBlock, cv::Rect& theShape, int theScroll, int theVisibleRows, int theRows) {
+		CVUI_TRACE_ZONE(internal::getContext(), "render::tableScrollbar");
+		int aThumbHeight = std::min(theShape.height, std::max(8, (int)((long long)theShape.height * theVisibleRows / theRows)));
+		int aThumbY = theShape.y + (int)((long long)(theShape.height - aThumbHeight) * theScroll / std::max(1, theRows - theVisibleRows));
+		cv::Rect aThumb(theShape.x + 1, aThumbY + 1, theShape.width - 2, aThumbHeight - 2);
+
+		const cvui_theme_t& aTheme = internal::theme();
+
+		CVUI_PROFILE_COUNT(PROFILE_PRIMITIVES);
+		internal::rectangle(theBlock.where, theShape, aTheme.scalars[THEME_TABLE_SCROLLBAR], CVUI_FILLED);
+		CVUI_PROFILE_COUNT(PROFILE_PRIMITIVES);
+		internal::rectangle(theBlock.where, aThumb, aTheme.scalars[THEME_TABLE_THUMB], CVUI_FILLED);
+	}
+
+	void annotationLabel(cv::Mat& theWhere, const cv::Mat& theLabel, cv::Point thePosition, int theStart, int theEnd) {
+		cv::Rect aTag(thePosition, theLabel.size());
+		cv::Rect aVisible = aTag & cv::Rect(0, theStart, theWhere.cols, theEnd - theStart);
+
+		if (aVisible.area() > 0) {
+			theLabel(cv::Rect(aVisible.tl() - aTag.tl(), aVisible.size())).copyTo(theWhere(aVisible));
+		}
+	}
+
+	template<int N>
+	void annotationRows(cv::Mat& theWhere, const cvui_annotation_t *theAnnotations, const cv::Mat *theLabels, const cv::Point *theLabelPositions, size_t theCount, int theStart, int theEnd) {
+		cv::Rect aFrame(0, 0, theWhere.cols, theWhere.rows);
+
+		for (size_t i = 0; i < theCount; i++) {
+			const cv::Rect& aBox = theAnnotations[i].box;
+			cv::Rect aClipped = aBox & aFrame;
+			int aTop = std::max(aClipped.y, theStart);
+			int aBottom = std::min(aClipped.y + aClipped.height, theEnd);
+
+			if (aClipped.area() > 0 && aTop < aBottom) {
+				cv::Scalar aBorder = internal::targetColor(theWhere, internal::hexToScalar(theAnnotations[i].color));
+				cv::Scalar aRequested = internal::hexToScalar(theAnnotations[i].fillingColor);
+				int aOpacity = 0xff - (int)aRequested[3]; // same alpha convention as rect().
+
+				// Opaque, as in rect(), so the alpha channel of 4-channel frames is blended like the colors.
+				cv::Scalar aFilling = internal::targetColor(theWhere, cv::Scalar(aRequested[0], aRequested[1], aRequested[2], 0));
+				uchar aBorderColor[N], aFillingColor[N];
+
+				for (int c = 0; c < N; c++) {
+					aBorderColor[c] = cv::saturate_cast<uchar>(aBorder[c]);
+					aFillingColor[c] = cv::saturate_cast<uchar>(aFilling[c]);
+				}
+
+				// Filling
+				for (int y = aTop; aOpacity > 0 && y < aBottom; y++) {
+					uchar *aPixel = theWhere.ptr<uchar>(y) + aClipped.x * N;
+					uchar *aEnd = aPixel + aClipped.width * N;
+
+					if (aOpacity == 0xff) {
+						for (; aPixel < aEnd; aPixel += N) {
+							for (int c = 0; c < N; c++) aPixel[c] = aFillingColor[c];
+						}
+					} else {
+						for (; aPixel < aEnd; aPixel += N) {
+							for (int c = 0; c < N; c++) aPixel[c] = (uchar)((aFillingColor[c] * aOpacity + aPixel[c] * (0xff - aOpacity) + 127) / 0xff);
+						}
+					}
+				}
+
+				// Border: the first and last rows are lines, the others are two pixels.
+				for (int y = aTop; y < aBottom; y++) {
+					uchar *aRow = theWhere.ptr<uchar>(y);
+
+					if (y == aBox.y || y == aBox.y + aBox.height - 1) {
+						for (int x = aClipped.x; x < aClipped.x + aClipped.width; x++) {
+							for (int c = 0; c < N; c++) aRow[x * N + c] = aBorderColor[c];
+						}
+					} else {
+						if (aBox.x == aClipped.x) {
+							for (int c = 0; c < N; c++) aRow[aBox.x * N + c] = aBorderColor[c];
+						}
+						if (aBox.x + aBox.width == aClipped.x + aClipped.width) {
+							for (int c = 0; c < N; c++) aRow[(aBox.x + aBox.width - 1) * N + c] = aBorderColor[c];
+						}
+					}
+				}
+			}
+
+			if (!theLabels[i].empty()) {
+				render::annotationLabel(theWhere, theLabels[i], theLabelPositions[i], theStart, theEnd);
+			}
+		}
+	}
+
+	// Draws annotations into a range of rows of a frame. Ranges are drawn by different
+	// threads and annotations are drawn in order within each range, see render::annotations().
+	struct AnnotationRows : public cv::ParallelLoopBody {
+		cv::Mat where;
+		const cvui_annotation_t *annotations;
+		const cv::Mat *labels;
+		const cv::Point *labelPositions;
+		size_t count;
+
+		inline AnnotationRows(cv::Mat& theWhere, const cvui_annotation_t *theAnnotations, const cv::Mat *theLabels, const cv::Point *theLabelPositions, size_t theCount)
+			: where(theWhere), annotations(theAnnotations), labels(theLabels), labelPositions(theLabelPositions), count(theCount) {}
+
+		void operator()(const cv::Range& theRows) const {
+			cv::Mat aWhere = where;
+
+			switch (aWhere.channels()) {
+				case 1: render::annotationRows<1>(aWhere, annotations, labels, labelPositions, count, theRows.start, theRows.end); break;
+				case 3: render::annotationRows<3>(aWhere, annotations, labels, labelPositions, count, theRows.start, theRows.end); break;
+				case 4: render::annotationRows<4>(aWhere, annotations, labels, labelPositions, count, theRows.start, theRows.end); break;
+			}
+		}
+	};
+
+	void annotations(cvui_block_t& theBlock, const cvui_annotation_t *theAnnotations, const cv::Mat *theLabels, const cv::Point *theLabelPositions, size_t theCount) {
+		CVUI_TRACE_ZONE(internal::getContext(), "render::annotations");
+		cv::Mat& aWhere = theBlock.where;
+		int aType = aWhere.type();
+
+		if (aType != CV_8UC1 && aType != CV_8UC3 && aType != CV_8UC4) {
+			// Rows of other types are not written directly, so each box is a regular rect.
+			for (size_t i = 0; i < theCount; i++) {
+				cv::Rect aBox = theAnnotations[i].box;
+				render::rect(theBlock, aBox, theAnnotations[i].color, theAnnotations[i].fillingColor);
+
+				if (!theLabels[i].empty()) {
+					render::annotationLabel(aWhere, theLabels[i], theLabelPositions[i], 0, aWhere.rows);
+				}
+			}
+			return;
+		}
 
-			cv::line(theBlock.where, aPoint1, aPoint2, internal::hexToScalar(theColor));
-			aPosX += aGap;
+		AnnotationRows aRows(aWhere, theAnnotations, theLabels, theLabelPositions, theCount);
+		CVUI_PROFILE_COUNT(PROFILE_PRIMITIVES);
+
+		// A few annotations are not worth waking up other threads.
+		if (theCount < 64) {
+			aRows(cv::Range(0, aWhere.rows));
+		} else {
+			cv::parallel_for_(cv::Range(0, aWhere.rows), aRows, std::max(1, aWhere.rows / 32));
 		}
 	}
 } // namespace render
 
-void init(const cv::String& theWindowName, int theDelayWaitKey, bool theCreateNamedWindow) {
+cvui_context_t *init(const cv::String& theWindowName, int theDelayWaitKey, bool theCreateNamedWindow) {
 	internal::init(theWindowName, theDelayWaitKey);
-	watch(theWindowName, theCreateNamedWindow);
+	return watch(theWindowName, theCreateNamedWindow);
 }
 
-void init(const cv::String theWindowNames[], size_t theHowManyWindows, int theDelayWaitKey, bool theCreateNamedWindows) {
+cvui_context_t *init(const cv::String theWindowNames[], size_t theHowManyWindows, int theDelayWaitKey, bool theCreateNamedWindows) {
 	internal::init(theWindowNames[0], theDelayWaitKey);
 
 	for (size_t i = 0; i < theHowManyWindows; i++) {
 		watch(theWindowNames[i], theCreateNamedWindows);
 	}
+
+	return internal::gDefaultContext.load();
 }
 
-void watch(const cv::String& theWindowName, bool theCreateNamedWindow) {
-	cvui_context_t aContex;
+cvui_context_t *watch(const cv::String& theWindowName, bool theCreateNamedWindow) {
+#ifdef CVUI_HEADLESS
+	// There is no highgui, so windows are just contexts.
+	(void)theCreateNamedWindow;
+	return internal::createContext(theWindowName, true);
+#else
+	// If the presenter thread is running, it creates the window itself.
+	bool aPresenter = internal::gPresenterRunning.load();
 
-	if (theCreateNamedWindow) {
+	if (theCreateNamedWindow && !aPresenter) {
 		cv::namedWindow(theWindowName);
 	}
 
-	aContex.windowName = theWindowName;
-	aContex.mouse.position.x = 0;
-	aContex.mouse.position.y = 0;
-	
-	internal::resetMouseButton(aContex.mouse.anyButton);
-	internal::resetMouseButton(aContex.mouse.buttons[RIGHT_BUTTON]);
-	internal::resetMouseButton(aContex.mouse.buttons[MIDDLE_BUTTON]);
-	internal::resetMouseButton(aContex.mouse.buttons[LEFT_BUTTON]);
+	cvui_context_t *aHandle = internal::createContext(theWindowName, false);
+
+	if (!aPresenter) {
+		cv::setMouseCallback(theWindowName, handleMouse, aHandle);
+	}
+
+	return aHandle;
+#endif
+}
 
-	internal::gContexts[theWindowName] = aContex;
-	cv::setMouseCallback(theWindowName, handleMouse, &internal::gContexts[theWindowName]);
+cvui_context_t *offscreen(const cv::String& theName) {
+	return internal::createContext(theName, true);
 }
 
 void context(const cv::String& theWindowName) {
-	internal::gCurrentContext = theWindowName;
+	internal::gCurrentContext = &internal::getContext(theWindowName);
 }
 
-void imshow(const cv::String& theWindowName, cv::InputArray theFrame) {
-	cvui::update(theWindowName);
-	cv::imshow(theWindowName, theFrame);
+void context(cvui_context_t *theContext) {
+	internal::gCurrentContext = theContext;
+}
+
+bool imshow(const cv::String& theWindowName, cv::InputArray theFrame) {
+	return cvui::imshow(&internal::getContext(theWindowName), theFrame);
+}
+
+bool imshow(cvui_context_t *theContext, cv::InputArray theFrame) {
+	bool aRedraw = cvui::update(theContext);
+
+#ifndef CVUI_HEADLESS
+	if (!theContext->offscreen) {
+		if (theContext->layer.empty()) {
+			cv::imshow(theContext->windowName, theFrame);
+		} else {
+			// The frame might be used by the caller, so the UI is blended into a frame of our own.
+			internal::composite(*theContext, theFrame.getMat(), theContext->composited);
+			cv::imshow(theContext->windowName, theContext->composited);
+		}
+	}
+#else
+	(void)theFrame;
+#endif
+
+	return aRedraw;
 }
 
 int lastKeyPressed() {
-	return internal::gLastKeyPressed;
+	const std::vector<cvui_key_event_t>& aKeys = internal::input(internal::getContext()).keys;
+	return aKeys.empty() ? -1 : aKeys.back().key;
+}
+
+const std::vector<cvui_key_event_t>& keys(const cv::String& theWindowName) {
+	return internal::input(internal::getContext(theWindowName)).keys;
 }
 
 cv::Point mouse(const cv::String& theWindowName) {
-	return internal::getContext(theWindowName).mouse.position;
+	return internal::input(internal::getContext(theWindowName)).mouse.position;
 }
 
 bool mouse(int theQuery) {
-	return mouse("", theQuery);
+	return internal::isMouseButton(internal::input(internal::getContext()).mouse.anyButton, theQuery);
 }
 
 bool mouse(const cv::String& theWindowName, int theQuery) {
-	cvui_mouse_btn_t& aButton = internal::getContext(theWindowName).mouse.anyButton;
+	cvui_mouse_btn_t& aButton = internal::input(internal::getContext(theWindowName)).mouse.anyButton;
 	bool aRet = internal::isMouseButton(aButton, theQuery);
 
 	return aRet;
 }
 
 bool mouse(int theButton, int theQuery) {
-	return mouse("", theButton, theQuery);
+	cvui_mouse_btn_t& aButton = internal::mouseButton(internal::input(internal::getContext()), theButton);
+	return internal::isMouseButton(aButton, theQuery);
 }
 
 bool mouse(const cv::String& theWindowName, int theButton, int theQuery) {
-	if (theButton != RIGHT_BUTTON && theButton != MIDDLE_BUTTON && theButton != LEFT_BUTTON) {
-		internal::error(6, "Invalid mouse button. Are you using one of the available: cvui::{RIGHT,MIDDLE,LEFT}_BUTTON ?");
-	}
-
-	cvui_mouse_btn_t& aButton = internal::getContext(theWindowName).mouse.buttons[theButton];
+	cvui_mouse_btn_t& aButton = internal::mouseButton(internal::input(internal::getContext(theWindowName)), theButton);
 	bool aRet = internal::isMouseButton(aButton, theQuery);
 
 	return aRet;
 }
 
+const std::vector<cvui_mouse_sample_t>& mouseSamples(const cv::String& theWindowName) {
+	return internal::input(internal::getContext(theWindowName)).mouseSamples;
+}
+
+unsigned int id(const cv::String& theId) {
+	cvui_context_t& aContext = internal::getContext();
+	unsigned int aId = internal::hash(theId.c_str(), theId.size(), aContext.idScopes.empty() ? internal::gHashSeed : aContext.idScopes.back());
+
+	aContext.nextId = aId == 0 ? 1 : aId;
+	return aContext.nextId;
+}
+
+void pushId(const cv::String& theId) {
+	cvui_context_t& aContext = internal::getContext();
+
+	if (aContext.idScopes.size() == aContext.idScopes.capacity()) {
+		internal::allocation(aContext, "idScopes", (aContext.idScopes.capacity() + 1) * sizeof(unsigned int));
+	}
+	aContext.idScopes.push_back(internal::hash(theId.c_str(), theId.size(), aContext.idScopes.empty() ? internal::gHashSeed : aContext.idScopes.back()));
+}
+
+void popId() {
+	cvui_context_t& aContext = internal::getContext();
+
+	if (aContext.idScopes.empty()) {
+		internal::error(7, "Mismatch in the number of pushId()/popId() calls. You are calling popId() more than pushId().");
+		return;
+	}
+
+	aContext.idScopes.pop_back();
+}
+
+unsigned int lastId() {
+	return internal::getContext().lastId;
+}
+
+cvui_widget_t& widget(unsigned int theId) {
+	return internal::widget(internal::getContext(), theId);
+}
+
 bool button(cv::Mat& theWhere, int theX, int theY, const cv::String& theLabel, double theFontScale, unsigned int theInsideColor) {
-	internal::gScreen.where = theWhere;
-	return internal::button(internal::gScreen, theX, theY, theLabel, theFontScale, theInsideColor);
+	cvui_block_t& aScreen = internal::screen(theWhere);
+	return internal::button(aScreen, theX, theY, theLabel, theFontScale, theInsideColor);
 }
 
 bool button(cv::Mat& theWhere, int theX, int theY, int theWidth, int theHeight, const cv::String& theLabel, double theFontScale, unsigned int theInsideColor) {
-	internal::gScreen.where = theWhere;
-	return internal::button(internal::gScreen, theX, theY, theWidth, theHeight, theLabel, true, theFontScale, theInsideColor);
+	cvui_block_t& aScreen = internal::screen(theWhere);
+	return internal::button(aScreen, theX, theY, theWidth, theHeight, theLabel, true, theFontScale, theInsideColor);
 }
 
 bool button(cv::Mat& theWhere, int theX, int theY, cv::Mat& theIdle, cv::Mat& theOver, cv::Mat& theDown) {
-	internal::gScreen.where = theWhere;
-	return internal::button(internal::gScreen, theX, theY, theIdle, theOver, theDown, true);
+	cvui_block_t& aScreen = internal::screen(theWhere);
+	return internal::button(aScreen, theX, theY, theIdle, theOver, theDown, true);
 }
 
 void image(cv::Mat& theWhere, int theX, int theY, cv::Mat& theImage) {
-	internal::gScreen.where = theWhere;
-	return internal::image(internal::gScreen, theX, theY, theImage);
+	cvui_block_t& aScreen = internal::screen(theWhere);
+	return internal::image(aScreen, theX, theY, theImage);
 }
 
 bool checkbox(cv::Mat& theWhere, int theX, int theY, const cv::String& theLabel, bool *theState, unsigned int theColor, double theFontScale) {
-	internal::gScreen.where = theWhere;
-	return internal::checkbox(internal::gScreen, theX, theY, theLabel, theState, theColor, theFontScale);
+	cvui_block_t& aScreen = internal::screen(theWhere);
+	return internal::checkbox(aScreen, theX, theY, theLabel, theState, theColor, theFontScale);
 }
 
 void text(cv::Mat& theWhere, int theX, int theY, const cv::String& theText, double theFontScale, unsigned int theColor) {
-	internal::gScreen.where = theWhere;
-	internal::text(internal::gScreen, theX, theY, theText, theFontScale, theColor, true);
+	cvui_block_t& aScreen = internal::screen(theWhere);
+	internal::text(aScreen, theX, theY, theText, theFontScale, theColor, true);
 }
 
 void printf(cv::Mat& theWhere, int theX, int theY, double theFontScale, unsigned int theColor, const char *theFmt, ...) {
@@ -2359,8 +5706,8 @@ void printf(cv::Mat& theWhere, int theX, int theY, double theFontScale, unsigned
 	vsprintf_s(internal::gBuffer, theFmt, aArgs);
 	va_end(aArgs);
 
-	internal::gScreen.where = theWhere;
-	internal::text(internal::gScreen, theX, theY, internal::gBuffer, theFontScale, theColor, true);
+	cvui_block_t& aScreen = internal::screen(theWhere);
+	internal::text(aScreen, theX, theY, internal::bufferText(), theFontScale, theColor, true);
 }
 
 void printf(cv::Mat& theWhere, int theX, int theY, const char *theFmt, ...) {
@@ -2370,36 +5717,75 @@ void printf(cv::Mat& theWhere, int theX, int theY, const char *theFmt, ...) {
 	vsprintf_s(internal::gBuffer, theFmt, aArgs);
 	va_end(aArgs);
 
-	internal::gScreen.where = theWhere;
-	internal::text(internal::gScreen, theX, theY, internal::gBuffer, DEFAULT_FONT_SCALE, 0xCECECE, true);
+	cvui_block_t& aScreen = internal::screen(theWhere);
+	internal::text(aScreen, theX, theY, internal::bufferText(), DEFAULT_FONT_SCALE, internal::theme().colors[THEME_TEXT], true);
 }
 
 int counter(cv::Mat& theWhere, int theX, int theY, int *theValue, int theStep, const char *theFormat, double theFontScale, unsigned int theInsideColor) {
-	internal::gScreen.where = theWhere;
-	return internal::counter(internal::gScreen, theX, theY, theValue, theStep, theFormat, theFontScale, theInsideColor);
+	cvui_block_t& aScreen = internal::screen(theWhere);
+	return internal::counter(aScreen, theX, theY, theValue, theStep, theFormat, theFontScale, theInsideColor);
 }
 
 double counter(cv::Mat& theWhere, int theX, int theY, double *theValue, double theStep, const char *theFormat, double theFontScale, unsigned int theInsideColor) {
-	internal::gScreen.where = theWhere;
-	return internal::counter(internal::gScreen, theX, theY, theValue, theStep, theFormat, theFontScale, theInsideColor);
+	cvui_block_t& aScreen = internal::screen(theWhere);
+	return internal::counter(aScreen, theX, theY, theValue, theStep, theFormat, theFontScale, theInsideColor);
 }
 
 void window(cv::Mat& theWhere, int theX, int theY, int theWidth, int theHeight, const cv::String& theTitle, double theFontScale) {
-	internal::gScreen.where = theWhere;
-	internal::window(internal::gScreen, theX, theY, theWidth, theHeight, theTitle, theFontScale);
+	cvui_block_t& aScreen = internal::screen(theWhere);
+	internal::window(aScreen, theX, theY, theWidth, theHeight, theTitle, theFontScale);
 }
 
 void rect(cv::Mat& theWhere, int theX, int theY, int theWidth, int theHeight, unsigned int theBorderColor, unsigned int theFillingColor) {
-	internal::gScreen.where = theWhere;
-	internal::rect(internal::gScreen, theX, theY, theWidth, theHeight, theBorderColor, theFillingColor);
+	cvui_block_t& aScreen = internal::screen(theWhere);
+	internal::rect(aScreen, theX, theY, theWidth, theHeight, theBorderColor, theFillingColor);
 }
 
 void sparkline(cv::Mat& theWhere, std::vector<double>& theValues, int theX, int theY, int theWidth, int theHeight, unsigned int theColor) {
-	internal::gScreen.where = theWhere;
-	internal::sparkline(internal::gScreen, theValues, theX, theY, theWidth, theHeight, theColor);
+	cvui_block_t& aScreen = internal::screen(theWhere);
+	internal::sparkline(aScreen, theValues, theX, theY, theWidth, theHeight, theColor);
+}
+
+int table(cv::Mat& theWhere, int theX, int theY, int theWidth, int theHeight, cvui_table_t *theTable, int theRows, int theColumns, const cv::String theHeaders[], const int theColumnWidths[], cvui_table_cell_t theCell, void *theData, double theFontScale) {
+	cvui_block_t& aScreen = internal::screen(theWhere);
+	return internal::table(aScreen, theX, theY, theWidth, theHeight, theTable, theRows, theColumns, theHeaders, theColumnWidths, theCell, theData, theFontScale);
+}
+
+void tableInvalidate(cvui_table_t *theTable, int theRow) {
+	if (theRow < 0) {
+		std::fill(theTable->cachedRows.begin(), theTable->cachedRows.end(), -1);
+
+	} else if (theTable->capacity > 0 && theTable->cachedRows[theRow % theTable->capacity] == theRow) {
+		theTable->cachedRows[theRow % theTable->capacity] = -1;
+	}
+}
+
+void annotations(cv::Mat& theWhere, const cvui_annotation_t *theAnnotations, size_t theCount, double theFontScale) {
+	cvui_block_t& aScreen = internal::screen(theWhere);
+	internal::annotations(aScreen, theAnnotations, theCount, theFontScale);
+}
+
+void annotations(cv::Mat& theWhere, const std::vector<cv::Rect>& theBoxes, const std::vector<cv::String>& theLabels, const std::vector<unsigned int>& theColors, unsigned int theFillingColor, double theFontScale) {
+	std::vector<cvui_annotation_t>& aAnnotations = internal::gAnnotations;
+
+	if (aAnnotations.capacity() < theBoxes.size()) {
+		internal::allocation("annotations", theBoxes.size() * sizeof(cvui_annotation_t));
+	}
+	aAnnotations.resize(theBoxes.size());
+
+	for (size_t i = 0; i < theBoxes.size(); i++) {
+		aAnnotations[i].box = theBoxes[i];
+		aAnnotations[i].label = i < theLabels.size() ? theLabels[i].c_str() : nullptr;
+		aAnnotations[i].color = theColors.empty() ? 0x00ff00 : theColors[i % theColors.size()];
+		aAnnotations[i].fillingColor = theFillingColor;
+	}
+
+	cvui_block_t& aScreen = internal::screen(theWhere);
+	internal::annotations(aScreen, aAnnotations.data(), aAnnotations.size(), theFontScale);
 }
 
 int iarea(int theX, int theY, int theWidth, int theHeight) {
+	internal::widgetId(nullptr, theX, theY);
 	return internal::iarea(theX, theY, theWidth, theHeight);
 }
 
@@ -2474,7 +5860,7 @@ void printf(double theFontScale, unsigned int theColor, const char *theFmt, ...)
 	vsprintf_s(internal::gBuffer, theFmt, aArgs);
 	va_end(aArgs);
 
-	internal::text(aBlock, aBlock.anchor.x, aBlock.anchor.y, internal::gBuffer, theFontScale, theColor, true);
+	internal::text(aBlock, aBlock.anchor.x, aBlock.anchor.y, internal::bufferText(), theFontScale, theColor, true);
 }
 
 void printf(const char *theFmt, ...) {
@@ -2485,7 +5871,7 @@ void printf(const char *theFmt, ...) {
 	vsprintf_s(internal::gBuffer, theFmt, aArgs);
 	va_end(aArgs);
 
-	internal::text(aBlock, aBlock.anchor.x, aBlock.anchor.y, internal::gBuffer, DEFAULT_FONT_SCALE, 0xCECECE, true);
+	internal::text(aBlock, aBlock.anchor.x, aBlock.anchor.y, internal::bufferText(), DEFAULT_FONT_SCALE, internal::theme().colors[THEME_TEXT], true);
 }
 
 int counter(int *theValue, int theStep, const char *theFormat, double theFontScale, unsigned int theInsideColor) {
@@ -2513,56 +5899,541 @@ void sparkline(std::vector<double>& theValues, int theWidth, int theHeight, unsi
 	internal::sparkline(aBlock, theValues, aBlock.anchor.x, aBlock.anchor.y, theWidth, theHeight, theColor);
 }
 
-void update(const cv::String& theWindowName) {
-	cvui_context_t& aContext = internal::getContext(theWindowName);
+int table(int theWidth, int theHeight, cvui_table_t *theTable, int theRows, int theColumns, const cv::String theHeaders[], const int theColumnWidths[], cvui_table_cell_t theCell, void *theData, double theFontScale) {
+	cvui_block_t& aBlock = internal::topBlock();
+	return internal::table(aBlock, aBlock.anchor.x, aBlock.anchor.y, theWidth, theHeight, theTable, theRows, theColumns, theHeaders, theColumnWidths, theCell, theData, theFontScale);
+}
+
+bool update(const cv::String& theWindowName) {
+	return cvui::update(&internal::getContext(theWindowName));
+}
+
+bool update(cvui_context_t *theContext) {
+	cvui_context_t& aContext = *theContext;
+
+	// Any input used in this frame (e.g. a click) might have changed
+	// something that was already rendered, so another frame is needed.
+	cvui_mouse_t& aMouse = aContext.mouse;
+	bool aRedraw = aContext.invalidated.exchange(false) || (aContext.inputPolled && (aMouse.anyButton.justPressed || aMouse.anyButton.justReleased || aMouse.wheel != 0 || !aContext.mouseSamples.empty() || !aContext.keys.empty()));
+
+	// The frame ends here, so the zone of update() is nested in the zone of the next frame.
+	internal::profileFrame(aContext);
+	CVUI_TRACE_ZONE(aContext, "update");
+
+	aContext.lastAllocations = aContext.allocations;
+	aContext.allocations = 0;
 
-	aContext.mouse.anyButton.justReleased = false;
-	aContext.mouse.anyButton.justPressed = false;
+	internal::resetRenderingBuffer(aContext.screen);
 
-	for (int i = cvui::LEFT_BUTTON; i <= cvui::RIGHT_BUTTON; i++) {
-		aContext.mouse.buttons[i].justReleased = false;
-		aContext.mouse.buttons[i].justPressed = false;
+	// If cvui::pump() was called since the last frame, it took care of the events of all windows.
+	// If we were told to keep track of the keyboard shortcuts, we proceed to handle opencv
+	// event queue otherwise (unless the presenter does it).
+	if (!aContext.pumped.exchange(false) && internal::gDelayWaitKey > 0 && !internal::gPresenterRunning.load()) {
+		int aKey = internal::waitKey(internal::gDelayWaitKey);
+
+		if (aKey != -1) {
+			internal::queueKey(aContext, aKey);
+		}
 	}
-	
-	internal::resetRenderingBuffer(internal::gScreen);
 
-	// If we were told to keep track of the keyboard shortcuts, we
-	// proceed to handle opencv event queue.
-	if (internal::gDelayWaitKey > 0) {
-		internal::gLastKeyPressed = cv::waitKey(internal::gDelayWaitKey);
+	internal::resetInput(aContext);
+
+	// Blocks and id scopes left open are closed and the frame is finished before the
+	// errors are reported, so the next frame starts clean even if the error policy throws.
+	bool aOpenBlocks = aContext.stackCount != -1;
+	bool aOpenIdScopes = !aContext.idScopes.empty();
+
+	aContext.stackCount = -1;
+	aContext.idScopes.clear();
+	aContext.nextId = 0;
+	aContext.frame++;
+	internal::gSkinFrame.fetch_add(1, std::memory_order_relaxed);
+
+	// Both errors belong to the frame that just ended, i.e. they are in cvui::errors() of this window.
+	aContext.errors += (aOpenBlocks ? 1 : 0) + (aOpenIdScopes ? 1 : 0);
+	aContext.lastErrors = aContext.errors;
+	aContext.errors = 0;
+
+	if (aOpenBlocks) {
+		internal::raise(2, "Calling update() before finishing all begin*()/end*() calls. Did you forget to call a begin*() or an end*()? Check if every begin*() has an appropriate end*() call before you call update().");
+	}
+
+	if (aOpenIdScopes) {
+		internal::raise(8, "Calling update() before finishing all pushId()/popId() calls. Check if every pushId() has an appropriate popId() call before you call update().");
+	}
+
+	return aRedraw || internal::hasPendingInput(aContext);
+}
+
+int pump(int theDelayWaitKey) {
+	int aDelay = theDelayWaitKey >= 0 ? theDelayWaitKey : (internal::gDelayWaitKey > 0 ? internal::gDelayWaitKey : 1);
+
+	// If the presenter thread is running, it handles the OpenCV events.
+	int aKey = internal::gPresenterRunning.load() ? -1 : internal::waitKey(aDelay);
+
+	if (aKey != -1) {
+		internal::queueKey(internal::getContext(), aKey);
+		aKey &= 0xff;
 	}
 
-	if (!internal::blockStackEmpty()) {
-		internal::error(2, "Calling update() before finishing all begin*()/end*() calls. Did you forget to call a begin*() or an end*()? Check if every begin*() has an appropriate end*() call before you call update().");
+	// Each window is only flagged: the input of a window belongs to the thread
+	// that updates it, so it is prepared by its next cvui::update().
+	std::lock_guard<std::mutex> aLock(internal::gContextsMutex);
+	for (auto& aEntry : internal::gContexts) {
+		aEntry.second.pumped.store(true);
 	}
+
+	return aKey;
 }
 
-void handleMouse(int theEvent, int theX, int theY, int /*theFlags*/, void* theData) {
-	int aButtons[3] = { cvui::LEFT_BUTTON, cvui::MIDDLE_BUTTON, cvui::RIGHT_BUTTON };
-	int aEventsDown[3] = { cv::EVENT_LBUTTONDOWN, cv::EVENT_MBUTTONDOWN, cv::EVENT_RBUTTONDOWN };
-	int aEventsUp[3] = { cv::EVENT_LBUTTONUP, cv::EVENT_MBUTTONUP, cv::EVENT_RBUTTONUP };
-	
+bool wait(int theTimeout) {
+	int64 aStart = cv::getTickCount();
+
+	while (true) {
+		{
+			std::lock_guard<std::mutex> aLock(internal::gContextsMutex);
+
+			for (auto& aEntry : internal::gContexts) {
+				if (aEntry.second.invalidated.load() || internal::hasPendingInput(aEntry.second)) {
+					return true;
+				}
+			}
+		}
+
+		int aSlice = internal::gWaitSlice;
+
+		if (theTimeout >= 0) {
+			int aElapsed = (int)((cv::getTickCount() - aStart) * 1000.0 / cv::getTickFrequency());
+
+			if (aElapsed >= theTimeout) {
+				return false;
+			}
+			aSlice = std::min(aSlice, std::max(1, theTimeout - aElapsed));
+		}
+
+		// Service OpenCV events, which might fill the event queues of the windows.
+		// If the presenter thread is running, it does that for us.
+		if (internal::gPresenterRunning.load()) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(aSlice));
+		} else {
+			int aKey = internal::waitKey(aSlice);
+
+			if (aKey != -1) {
+				internal::queueKey(internal::getContext(), aKey);
+			}
+		}
+	}
+}
+
+void invalidate() {
+	std::lock_guard<std::mutex> aLock(internal::gContextsMutex);
+
+	for (auto& aEntry : internal::gContexts) {
+		aEntry.second.invalidated.store(true);
+	}
+}
+
+void startPresenter(int theDelayWaitKey) {
+	if (internal::gPresenterRunning.exchange(true)) {
+		return;
+	}
+
+	static bool aRegistered = false;
+	if (!aRegistered) {
+		std::atexit(stopPresenter);
+		aRegistered = true;
+	}
+
+	internal::gPresenterThread = std::thread(internal::presenterLoop, theDelayWaitKey > 0 ? theDelayWaitKey : 1);
+}
+
+void stopPresenter() {
+	if (internal::gPresenterRunning.exchange(false)) {
+		internal::gPresenterThread.join();
+	}
+}
+
+bool present(cvui_context_t *theContext, cv::Mat& theFrame) {
+	if (!internal::gPresenterRunning.load()) {
+		return cvui::imshow(theContext, theFrame);
+	}
+
+	bool aRedraw = cvui::update(theContext);
+	cvui_triple_buffer_t& aFrames = theContext->frames;
+
+	// The frame is handed over anyway, so the UI is blended into it.
+	if (!theContext->layer.empty()) {
+		internal::composite(*theContext, theFrame, theFrame);
+	}
+
+	if (!theContext->presented) {
+		std::lock_guard<std::mutex> aLock(internal::gPresenterMutex);
+		internal::gPresented.push_back(theContext);
+		theContext->presented = true;
+	}
+
+	// Move ownership of the pixels instead of copying them. The frame becomes
+	// the back buffer, which is then published as the fresh middle buffer.
+	cv::Size aSize = theFrame.size();
+	int aType = theFrame.type();
+
+	aFrames.buffers[aFrames.back] = theFrame;
+	aFrames.back = aFrames.middle.exchange(aFrames.back | cvui_triple_buffer_t::FRESH, std::memory_order_acq_rel) & ~cvui_triple_buffer_t::FRESH;
+
+	// Hand the buffer we got back (no one is using it) to the caller, so the next
+	// frame has where to be rendered into. It is only allocated in the first frames.
+	theFrame = aFrames.buffers[aFrames.back];
+	aFrames.buffers[aFrames.back].release();
+	theFrame.create(aSize, aType);
+
+	return aRedraw;
+}
+
+bool present(const cv::String& theWindowName, cv::Mat& theFrame) {
+	return cvui::present(&internal::getContext(theWindowName), theFrame);
+}
+
+cv::Mat& layer(cv::Size theSize, cvui_context_t *theContext) {
+	cvui_context_t& aContext = theContext != nullptr ? *theContext : internal::getContext();
+
+	if (theSize.area() <= 0) {
+		aContext.layer.release();
+		aContext.composited.release();
+		return aContext.layer;
+	}
+
+	if (aContext.layer.size() != theSize) {
+		internal::allocation(aContext, "layer", theSize.area() * 4);
+		aContext.layer.create(theSize, CV_8UC4);
+	}
+
+	// Transparent black, i.e. nothing, in the premultiplied colors of the layer.
+	aContext.layer.setTo(cv::Scalar::all(0));
+	aContext.layerRows.clear();
+
+	return aContext.layer;
+}
+
+void composite(cv::Mat& theFrame, cvui_context_t *theContext) {
+	cvui_context_t& aContext = theContext != nullptr ? *theContext : internal::getContext();
+
+	if (!aContext.layer.empty()) {
+		internal::composite(aContext, theFrame, theFrame);
+	}
+}
+
+void injectMouse(cvui_context_t *theContext, int theEvent, int theX, int theY, int theFlags) {
+	cvui::handleMouse(theEvent, theX, theY, theFlags, theContext);
+}
+
+void injectKey(cvui_context_t *theContext, int theKey) {
+	internal::ringPush(theContext->keyEvents, internal::keyEvent(theKey, cv::getTickCount()));
+}
+
+bool record(cvui_context_t *theContext, const cv::String& theFilename) {
+	cvui::stopRecording(theContext);
+
+	FILE *aFile = fopen(theFilename.c_str(), "wb");
+	if (aFile == nullptr) {
+		return false;
+	}
+
+	fwrite(internal::gRecordingMagic, sizeof(internal::gRecordingMagic), 1, aFile);
+	fwrite(&internal::gRecordingByteOrder, sizeof(internal::gRecordingByteOrder), 1, aFile);
+	theContext->recording = aFile;
+	theContext->recordingStart = theContext->frame;
+
+	return true;
+}
+
+void stopRecording(cvui_context_t *theContext) {
+	if (theContext->recording != nullptr) {
+		fclose(theContext->recording);
+		theContext->recording = nullptr;
+	}
+}
+
+bool replay(cvui_context_t *theContext, const cv::String& theFilename) {
+	FILE *aFile = fopen(theFilename.c_str(), "rb");
+	if (aFile == nullptr) {
+		return false;
+	}
+
+	char aMagic[sizeof(internal::gRecordingMagic)];
+	uint32_t aByteOrder = 0;
+	bool aValid = fread(aMagic, sizeof(aMagic), 1, aFile) == 1 && memcmp(aMagic, internal::gRecordingMagic, sizeof(aMagic)) == 0;
+	cvui_input_record_t aRecord;
+
+	// Files written by a machine of the other byte order have every field of their records swapped.
+	aValid = aValid && fread(&aByteOrder, sizeof(aByteOrder), 1, aFile) == 1 && (aByteOrder == 0x01020304 || aByteOrder == 0x04030201);
+	bool aSwap = aByteOrder == 0x04030201;
+
+	theContext->replay.clear();
+	while (aValid && fread(&aRecord, sizeof(aRecord), 1, aFile) == 1) {
+		if (aSwap) {
+			internal::swapRecord(aRecord);
+		}
+		theContext->replay.push_back(aRecord);
+	}
+	fclose(aFile);
+
+	theContext->replayNext = 0;
+	theContext->replayStart = theContext->frame;
+
+	return aValid;
+}
+
+bool replaying(cvui_context_t *theContext) {
+	return theContext->replayNext < theContext->replay.size();
+}
+
+const cvui_profile_t& profile(cvui_context_t *theContext) {
+	return theContext != nullptr ? theContext->lastProfile : internal::getContext().lastProfile;
+}
+
+void profiler(cv::Mat& theWhere, int theX, int theY, int theTopWidgets, cvui_context_t *theContext) {
+	const cvui_profile_t& aProfile = cvui::profile(theContext);
+	const int aWidth = 230, aLine = 14, aBars = 50, aBarsHeight = 40;
+	const cv::Scalar aColor(0xCE, 0xCE, 0xCE);
+	std::vector<cvui_profile_widget_t> aTop;
+	std::vector<double> aSorted(aProfile.history);
+	double aMax = 0;
+	int aY = theY;
+
+	// Components rendered more than once (e.g. in a loop) are listed as one.
+	for (size_t i = 0; i < aProfile.widgets.size(); i++) {
+		size_t j = 0;
+		while (j < aTop.size() && aTop[j].id != aProfile.widgets[i].id) {
+			j++;
+		}
+
+		if (j == aTop.size()) {
+			aTop.push_back(aProfile.widgets[i]);
+		} else {
+			aTop[j].time += aProfile.widgets[i].time;
+		}
+	}
+
+	std::sort(aTop.begin(), aTop.end(), [](const cvui_profile_widget_t& a, const cvui_profile_widget_t& b) { return a.time > b.time; });
+	aTop.resize(std::min(aTop.size(), (size_t)std::max(theTopWidgets, 0)));
+
+	std::sort(aSorted.begin(), aSorted.end());
+	aMax = aSorted.empty() ? 0 : aSorted.back();
+
+	int aHeight = aLine * (5 + (int)aTop.size()) + aBarsHeight + 10;
+	internal::rectangle(theWhere, cv::Rect(theX, theY, aWidth, aHeight), cv::Scalar(0x31, 0x31, 0x31), CVUI_FILLED);
+	internal::rectangle(theWhere, cv::Rect(theX, theY, aWidth, aHeight), cv::Scalar(0x45, 0x45, 0x45), 1);
+
+#ifndef CVUI_PROFILER
+	internal::putText(theWhere, "profiler disabled (CVUI_PROFILER)", cv::Point(theX + 5, aY + aLine), 0.35, aColor);
+#endif
+
+	aY += aLine;
+	sprintf_s(internal::gBuffer, "frame %.2f ms (%.0f fps)", aProfile.frameTime, aProfile.frameTime > 0 ? 1000.0 / aProfile.frameTime : 0.0);
+	internal::putText(theWhere, internal::gBuffer, cv::Point(theX + 5, aY + aLine), 0.35, aColor);
+
+	if (!aSorted.empty()) {
+		aY += aLine;
+		sprintf_s(internal::gBuffer, "p50 %.2f  p90 %.2f  p99 %.2f ms", aSorted[aSorted.size() * 50 / 100], aSorted[aSorted.size() * 90 / 100], aSorted[aSorted.size() * 99 / 100]);
+		internal::putText(theWhere, internal::gBuffer, cv::Point(theX + 5, aY + aLine), 0.35, aColor);
+
+		// Duration of recent frames by percentile, i.e. the bar i is the percentile i * 100 / aBars.
+		for (int i = 0; i < aBars && aMax > 0; i++) {
+			double aValue = aSorted[aSorted.size() * i / aBars];
+			int aBar = std::max(1, (int)(aValue / aMax * aBarsHeight));
+			internal::rectangle(theWhere, cv::Rect(theX + 5 + i * 4, aY + aLine + 5 + aBarsHeight - aBar, 3, aBar), cv::Scalar(0x50, 0xC0, 0x50), CVUI_FILLED);
+		}
+	}
+	aY += aBarsHeight + 5;
+
+	aY += aLine;
+	sprintf_s(internal::gBuffer, "primitives %u  text sizes %u", aProfile.counters[PROFILE_PRIMITIVES], aProfile.counters[PROFILE_TEXT_MEASUREMENTS]);
+	internal::putText(theWhere, internal::gBuffer, cv::Point(theX + 5, aY + aLine), 0.35, aColor);
+
+	aY += aLine;
+	sprintf_s(internal::gBuffer, "allocations %u  cache hits %u", aProfile.counters[PROFILE_ALLOCATIONS], aProfile.counters[PROFILE_CACHE_HITS]);
+	internal::putText(theWhere, internal::gBuffer, cv::Point(theX + 5, aY + aLine), 0.35, aColor);
+
+	for (size_t i = 0; i < aTop.size(); i++) {
+		aY += aLine;
+		sprintf_s(internal::gBuffer, "%08x %-9s %.3f ms", aTop[i].id, internal::gProfileCategories[aTop[i].category], aTop[i].time);
+		internal::putText(theWhere, internal::gBuffer, cv::Point(theX + 5, aY + aLine), 0.35, aColor);
+	}
+}
+
+void trace(int theFrames, cvui_context_t *theContext) {
+	cvui_context_t& aContext = theContext != nullptr ? *theContext : internal::getContext();
+	cvui_trace_frame_t aEmpty;
+
+	// No slot belongs to a frame yet.
+	aEmpty.frame = aContext.frame - 1;
+	aContext.trace.assign(std::max(theFrames, 0), aEmpty);
+}
+
+unsigned int allocations(cvui_context_t *theContext) {
+	return theContext != nullptr ? theContext->lastAllocations : internal::getContext().lastAllocations;
+}
+
+void allocationHook(cvui_allocation_hook_t theHook, void *theData) {
+	internal::gAllocationHook = theHook;
+	internal::gAllocationHookData = theData;
+}
+
+void skin(int theSkin, const cv::Mat& theImage, int theLeft, int theTop, int theRight, int theBottom, int theState) {
+	if (theSkin < 0 || theSkin >= SKIN_TYPES) {
+		internal::error(11, "Invalid skin. Are you using one of the available: cvui::SKIN_{BUTTON,WINDOW_TITLE,WINDOW,TRACKBAR,TRACKBAR_HANDLE} ?");
+		return;
+	}
+
+	if (!theImage.empty() && (theImage.depth() != CV_8U || theImage.channels() == 2 || theImage.channels() > 4 || theLeft < 0 || theTop < 0 || theRight < 0 || theBottom < 0 || theLeft + theRight >= theImage.cols || theTop + theBottom >= theImage.rows)) {
+		internal::error(11, "Invalid skin image. It must be CV_8UC1, CV_8UC3 or CV_8UC4, and its borders must leave at least one pixel in the center.");
+		return;
+	}
+
+	// Reported before locking gSkinsMutex, since the error callback might use skins.
+	internal::allocation("skins", theImage.total() * theImage.elemSize());
+	cv::Mat aImage = theImage.clone();
+
+	std::lock_guard<std::mutex> aLock(internal::gSkinsMutex);
+	cvui_skin_t& aSkin = internal::gSkins[theSkin][theState == OUT ? 0 : (theState == OVER ? 1 : 2)];
+
+	aSkin.image = aImage;
+	aSkin.left = theLeft;
+	aSkin.top = theTop;
+	aSkin.right = theRight;
+	aSkin.bottom = theBottom;
+
+	aSkin.cache.clear();
+
+	bool aSkinned = false;
+	for (int i = 0; i < SKIN_TYPES * 3; i++) {
+		aSkinned = aSkinned || !internal::gSkins[i / 3][i % 3].image.empty();
+	}
+	internal::gSkinned.store(aSkinned, std::memory_order_release);
+}
+
+void cvui_theme_t::prepare() {
+	internal::prepareTheme(*this);
+}
+
+bool cvui_theme_t::dirty() const {
+	return memcmp(colors, prepared, sizeof(prepared)) != 0;
+}
+
+void theme(cvui_theme_t *theTheme) {
+	// Themes are prepared here, so they are only read from now on.
+	if (theTheme != nullptr && theTheme->dirty()) {
+		theTheme->prepare();
+	}
+
+	internal::gTheme.store(theTheme, std::memory_order_release);
+
+	const cvui_theme_t& aTheme = internal::theme();
+	DEFAULT_FONT_SCALE = aTheme.fontScale;
+	DEFAULT_BUTTON_COLOR = aTheme.colors[THEME_BUTTON];
+	DEFAULT_TEXT_COLOR = aTheme.colors[THEME_TEXT];
+}
+
+void errorPolicy(int thePolicy, cvui_error_callback_t theCallback, void *theData) {
+	internal::gErrorCallback = theCallback;
+	internal::gErrorCallbackData = theData;
+	internal::gErrorPolicy.store(thePolicy);
+}
+
+unsigned int errors(cvui_context_t *theContext) {
+	return theContext != nullptr ? theContext->lastErrors : internal::getContext().lastErrors;
+}
+
+void steadyState(int theWarmupFrames, cvui_context_t *theContext) {
+	cvui_context_t& aContext = theContext != nullptr ? *theContext : internal::getContext();
+
+	aContext.steadyState = theWarmupFrames >= 0;
+	aContext.steadyStateStart = aContext.frame + (theWarmupFrames >= 0 ? theWarmupFrames : 0);
+}
+
+bool saveTrace(const cv::String& theFilename, cvui_context_t *theContext) {
+	cvui_context_t& aContext = theContext != nullptr ? *theContext : internal::getContext();
+	std::vector<const cvui_trace_frame_t *> aFrames;
+	double aTicksPerUs = cv::getTickFrequency() / 1000000.0;
+	int64 aOrigin = 0;
+	FILE *aFile = fopen(theFilename.c_str(), "w");
+
+	if (aFile == nullptr) {
+		return false;
+	}
+
+	for (size_t i = 0; i < aContext.trace.size(); i++) {
+		const cvui_trace_frame_t& aFrame = aContext.trace[i];
+
+		if (!aFrame.events.empty() && aContext.frame - aFrame.frame < aContext.trace.size()) {
+			aFrames.push_back(&aFrame);
+		}
+	}
+
+	std::sort(aFrames.begin(), aFrames.end(), [](const cvui_trace_frame_t *a, const cvui_trace_frame_t *b) { return a->frame < b->frame; });
+
+	// Timestamps are informed relative to the oldest zone, in microseconds.
+	for (size_t i = 0; i < aFrames.size(); i++) {
+		for (size_t j = 0; j < aFrames[i]->events.size(); j++) {
+			if (aOrigin == 0 || aFrames[i]->events[j].start < aOrigin) {
+				aOrigin = aFrames[i]->events[j].start;
+			}
+		}
+	}
+
+	fprintf(aFile, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	fprintf(aFile, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"cvui\"}},\n");
+	fprintf(aFile, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":");
+	internal::writeJsonString(aFile, aContext.windowName.c_str());
+	fprintf(aFile, "}}");
+
+	for (size_t i = 0; i < aFrames.size(); i++) {
+		for (size_t j = 0; j < aFrames[i]->events.size(); j++) {
+			const cvui_trace_event_t& aEvent = aFrames[i]->events[j];
+
+			fprintf(aFile, ",\n{\"name\":\"%s\",\"cat\":\"cvui\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%u",
+				aEvent.name, (aEvent.start - aOrigin) / aTicksPerUs, (aEvent.end - aEvent.start) / aTicksPerUs, aFrames[i]->frame);
+
+			if (aEvent.id != 0) {
+				fprintf(aFile, ",\"id\":\"%08x\"", aEvent.id);
+			}
+			fprintf(aFile, "}}");
+		}
+	}
+
+	fprintf(aFile, "\n]}\n");
+	return fclose(aFile) == 0;
+}
+
+void handleMouse(int theEvent, int theX, int theY, int theFlags, void* theData) {
 	cvui_context_t *aContext = (cvui_context_t *)theData;
-	
-	for (int i = 0; i < 3; i++) {
-		int aBtn = aButtons[i];
+	cvui_mouse_event_t aEvent;
+
+	aEvent.type = theEvent;
+	aEvent.position = cv::Point(theX, theY);
+	aEvent.wheel = 0;
+	aEvent.timestamp = cv::getTickCount();
+
+	// No component scrolls horizontally, and the coordinates of wheel events might be
+	// screen coordinates (see applyMouseEvent()), so horizontal wheel events are ignored.
+	if (theEvent == EVENT_MOUSEHWHEEL) {
+		return;
+	}
 
-		if (theEvent == aEventsDown[i]) {
-			aContext->mouse.anyButton.justPressed = true;
-			aContext->mouse.anyButton.pressed = true;
-			aContext->mouse.buttons[aBtn].justPressed = true;
-			aContext->mouse.buttons[aBtn].pressed = true;
+	if (theEvent == EVENT_MOUSEWHEEL) {
+		// Same as cv::getMouseWheelDelta(), which is not available without highgui.
+		aEvent.wheel = (short)((theFlags >> 16) & 0xFFFF);
 
-		} else if (theEvent == aEventsUp[i]) {
-			aContext->mouse.anyButton.justReleased = true;
-			aContext->mouse.anyButton.pressed = false;
-			aContext->mouse.buttons[aBtn].justReleased = true;
-			aContext->mouse.buttons[aBtn].pressed = false;
+		if (aEvent.wheel == 0) {
+			return;
 		}
 	}
-	
-	aContext->mouse.position.x = theX;
-	aContext->mouse.position.y = theY;
+
+	aContext->mouseActivity.store(aEvent.timestamp, std::memory_order_relaxed);
+
+	// Events are only queued here. They are applied to the mouse state by the thread
+	// building the UI of the window, so no interaction is lost in slow frames.
+	internal::ringPush(aContext->mouseEvents, aEvent);
 }
 
 } // namespace cvui
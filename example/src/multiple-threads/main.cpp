@@ -0,0 +1,135 @@
+/*
+This demo shows how the UI of several windows can be built at the same
+time, each one by its own thread. Every thread informs cvui which window
+it is working on by calling cvui::context(), then renders components and
+calls cvui::update() as usual. The current context, the stack of begin*()/end*()
+blocks and the last key pressed are kept per thread/window, so threads
+don't step on each other.
+
+OpenCV windows (highgui) must be managed by a single thread, so the main
+thread is the only one that calls cv::imshow() and cv::waitKey(). Worker
+threads only render into their own frames.
+
+The demo doubles as a stress test: it can run for a fixed amount of frames. Build it with -fsanitize=thread (e.g. using
+CMAKE_CXX_FLAGS="-fsanitize=thread -g") to check for data races:
+
+  ./multiple-threads 8 1000
+
+The first argument is the amount of windows/threads (default 4), the second
+is the amount of frames to run (default: run until ESC is pressed).
+
+Code licensed under the MIT license, check LICENSE file.
+*/
+
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+#define CVUI_IMPLEMENTATION
+#include "cvui.h"
+
+// Data shared between a worker thread and the main thread.
+struct Window {
+	cv::String name;
+	cvui::cvui_context_t *handle;
+	std::mutex lock;
+	cv::Mat shown;            // last frame finished by the worker, protected by lock.
+	int frames = 0;           // frames rendered by the worker, protected by lock.
+};
+
+std::atomic<bool> running(true);
+
+void worker(Window *window, int maxFrames) {
+	cv::Mat frame = cv::Mat(220, 400, CV_8UC3);
+	std::vector<double> values;
+	double value = 0.5;
+	bool checked = false;
+	int count = 0;
+
+	for (int i = 0; running && (maxFrames <= 0 || i < maxFrames); i++) {
+		frame = cv::Scalar(49, 52, 49);
+
+		// Tell cvui which window the components rendered by this thread belong to.
+		cvui::context(window->handle);
+
+		cvui::printf(frame, 10, 10, "%s - frame %d", window->name.c_str(), i);
+
+		cvui::beginColumn(frame, 10, 30, -1, -1, 6);
+			cvui::beginRow();
+				cvui::button("Button");
+				cvui::counter(&count);
+			cvui::endRow();
+			cvui::checkbox("Checkbox", &checked);
+			cvui::trackbar(300, &value, 0., 1.);
+			cvui::window(300, 40, "Window");
+		cvui::endColumn();
+
+		values.push_back(std::sin(i * 0.1) + (rand() % 100) / 500.0);
+		if (values.size() > 100) {
+			values.erase(values.begin());
+		}
+		cvui::sparkline(frame, values, 10, 180, 380, 30);
+
+		// If any other thread had touched our block stack, cvui would complain
+		// about unbalanced begin*()/end*() calls here.
+		cvui::update(window->handle);
+
+		std::lock_guard<std::mutex> aLock(window->lock);
+		frame.copyTo(window->shown);
+		window->frames++;
+	}
+}
+
+int main(int argc, const char *argv[])
+{
+	int howMany = argc > 1 ? std::max(1, atoi(argv[1])) : 4;
+	int maxFrames = argc > 2 ? atoi(argv[2]) : 0;
+
+	std::vector<cv::String> names;
+	for (int i = 0; i < howMany; i++) {
+		names.push_back(cv::format("Thread %d", i + 1));
+	}
+
+	// Create all windows from the main thread. No delay for cv::waitKey() is
+	// informed, so cvui::update() never calls highgui from the worker threads.
+	cvui::init(names.data(), names.size());
+
+	std::vector<Window> windows(howMany);
+	std::vector<std::thread> threads;
+
+	for (int i = 0; i < howMany; i++) {
+		windows[i].name = names[i];
+		windows[i].handle = cvui::watch(names[i], false);
+		threads.push_back(std::thread(worker, &windows[i], maxFrames));
+	}
+
+	while (running) {
+		bool done = maxFrames > 0;
+
+		for (auto& window : windows) {
+			std::lock_guard<std::mutex> aLock(window.lock);
+
+			if (!window.shown.empty()) {
+				cv::imshow(window.name, window.shown);
+			}
+			done = done && window.frames >= maxFrames;
+		}
+
+		// Check if ESC key was pressed or all threads are finished.
+		if (cv::waitKey(20) == 27 || done) {
+			running = false;
+		}
+	}
+
+	for (size_t i = 0; i < threads.size(); i++) {
+		threads[i].join();
+		std::cout << windows[i].name << ": " << windows[i].frames << " frames" << std::endl;
+	}
+
+	return 0;
+}
@@ -48,9 +48,14 @@ E.g.
 In that case, you don't have to bother calling cvui::update() yourself, since
 cvui::imshow() will do it for you.
 
+At the end of the frame, cvui::pump() handles the events of all windows with a
+single call to cv::waitKey(), so the frame latency does not depend on the
+number of windows.
+
 Code licensed under the MIT license, check LICENSE file.
 */
 
+#include <iostream>
 #include <opencv2/core/core.hpp>
 #include <opencv2/highgui/highgui.hpp>
 
@@ -143,8 +148,8 @@ int main(int argc, const char *argv[])
 		// call cvui::update() for us.
 		compact(WINDOW4_NAME);
 
-		// Check if ESC key was pressed
-		if (cv::waitKey(20) == 27) {
+		// Handle the events of all windows at once, then check if ESC key was pressed.
+		if (cvui::pump(20) == 27) {
 			break;
 		}
 	}
@@ -0,0 +1,59 @@
+/*
+This demo shows how to use a presenter thread, so the loop that processes
+images and renders the UI never blocks on the window system.
+
+cvui::startPresenter() starts a thread that creates the windows, shows
+the frames and handles the mouse/keyboard events. The main loop hands
+each finished frame over to that thread using cvui::present(), which
+moves the frame instead of copying it and gives back a buffer to render
+the next frame into. Input flows back into cvui through lock-free queues,
+so components work as usual.
+
+Code licensed under the MIT license, check LICENSE file.
+*/
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+#define CVUI_IMPLEMENTATION
+#include "cvui.h"
+
+#define WINDOW_NAME "Presenter"
+
+int main(int argc, const char *argv[])
+{
+	cv::Mat frame = cv::Mat(300, 600, CV_8UC3);
+	cv::Mat noise = cv::Mat(300, 600, CV_8UC1);
+	int blur = 5;
+	bool running = true;
+
+	// The presenter must be started before cvui::init(), because it
+	// is the one creating the windows.
+	cvui::startPresenter();
+	cvui::cvui_context_t *window = cvui::init(WINDOW_NAME);
+
+	while (running) {
+		// Some heavy processing that would make the UI sluggish if the
+		// window system had to be serviced by this loop.
+		cv::randu(noise, 0, 255);
+		cv::GaussianBlur(noise, noise, cv::Size(blur * 2 + 1, blur * 2 + 1), 0);
+		cv::cvtColor(noise, frame, cv::COLOR_GRAY2BGR);
+
+		cvui::window(frame, 10, 10, 220, 110, "Settings");
+		cvui::text(frame, 20, 40, "Blur radius");
+		cvui::counter(frame, 20, 60, &blur);
+		blur = std::max(0, blur);
+
+		if (cvui::button(frame, 130, 55, "&Quit")) {
+			running = false;
+		}
+
+		// Move the frame to the presenter thread. After this call, frame
+		// is a recycled buffer with undefined content.
+		cvui::present(window, frame);
+	}
+
+	cvui::stopPresenter();
+	return 0;
+}
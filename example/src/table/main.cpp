@@ -0,0 +1,97 @@
+/*
+This is a demo application to showcase the table component of cvui.
+The table does not store any data: it asks a function to format the
+cells that are visible, so it can display a huge amount of rows, e.g.
+the results of an object detector.
+
+Code licensed under the MIT license, check LICENSE file.
+*/
+
+#include <iostream>
+#include <cstdio>
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+#define CVUI_IMPLEMENTATION
+#include "cvui.h"
+
+#define WINDOW_NAME	"Table"
+
+struct Detection {
+	int id;
+	int label;
+	float score;
+	cv::Rect box;
+};
+
+// Format the content of a cell. This function is only called for rows
+// that became visible, since cvui caches the text of the visible cells.
+void cell(int theRow, int theColumn, char *theBuffer, size_t theBufferSize, void *theData) {
+	const std::vector<Detection>& detections = *static_cast<std::vector<Detection> *>(theData);
+	const Detection& d = detections[theRow];
+
+	switch (theColumn) {
+		case 0: snprintf(theBuffer, theBufferSize, "%d", d.id); break;
+		case 1: snprintf(theBuffer, theBufferSize, "class %d", d.label); break;
+		case 2: snprintf(theBuffer, theBufferSize, "%.3f", d.score); break;
+		case 3: snprintf(theBuffer, theBufferSize, "%d", d.box.x); break;
+		case 4: snprintf(theBuffer, theBufferSize, "%d", d.box.y); break;
+		case 5: snprintf(theBuffer, theBufferSize, "%d", d.box.width); break;
+		case 6: snprintf(theBuffer, theBufferSize, "%d", d.box.height); break;
+		case 7: snprintf(theBuffer, theBufferSize, "%s", d.score > 0.5f ? "yes" : "no"); break;
+	}
+}
+
+int main(int argc, const char *argv[])
+{
+	cv::Mat frame = cv::Mat(500, 700, CV_8UC3);
+	std::vector<Detection> detections;
+	cvui::cvui_table_t table;
+
+	const cv::String headers[] = { "Id", "Label", "Score", "X", "Y", "Width", "Height", "Valid" };
+	const int widths[] = { 60, 90, 70, 70, 70, 80, 80, 60 };
+
+	// Create lots of fake detections
+	for (int i = 0; i < 50000; i++) {
+		Detection d;
+		d.id = i;
+		d.label = rand() % 80;
+		d.score = (rand() % 1000) / 1000.0f;
+		d.box = cv::Rect(rand() % 1920, rand() % 1080, 10 + rand() % 200, 10 + rand() % 200);
+		detections.push_back(d);
+	}
+
+	// Init cvui and tell it to create a OpenCV window, i.e. cv::namedWindow(WINDOW_NAME).
+	cvui::init(WINDOW_NAME);
+
+	while (true) {
+		// Fill the frame with a nice color
+		frame = cv::Scalar(49, 52, 49);
+
+		// Render the table. It returns the index of the selected row (or -1).
+		int selected = cvui::table(frame, 10, 10, 680, 420, &table, (int)detections.size(), 8, headers, widths, cell, &detections);
+
+		if (selected >= 0) {
+			cvui::printf(frame, 10, 445, "Selected detection: %d (score %.3f)", detections[selected].id, detections[selected].score);
+		} else {
+			cvui::printf(frame, 10, 445, "Click a row to select it. Use the mouse wheel or the scrollbar to scroll.");
+		}
+
+		// The score of the selected detection changes when the button is clicked.
+		// Since that row might be visible, its cached text must be discarded.
+		if (selected >= 0 && cvui::button(frame, 10, 465, "Change score")) {
+			detections[selected].score = (rand() % 1000) / 1000.0f;
+			cvui::tableInvalidate(&table, selected);
+		}
+
+		// Update cvui stuff and show everything on the screen
+		cvui::imshow(WINDOW_NAME, frame);
+
+		// Check if ESC key was pressed
+		if (cv::waitKey(20) == 27) {
+			break;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,63 @@
+/*
+This demo shows how to render the UI into a layer of its own, which is
+blended over the frames of a video.
+
+When the UI and the video share the same cv::Mat, the whole UI must be
+rendered again on every new frame of the video. With cvui::layer(), the
+UI is rendered into a separate image only when it changes (i.e. when
+cvui::imshow() returns true), and cvui::imshow() blends it over each
+frame, which is much cheaper than rendering it.
+
+Code licensed under the MIT license, check LICENSE file.
+*/
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+#define CVUI_IMPLEMENTATION
+#include "cvui.h"
+
+#define WINDOW_NAME "UI layer"
+
+int main(int argc, const char *argv[])
+{
+	cv::Mat frame = cv::Mat(400, 600, CV_8UC3);
+	cv::Mat gradient = cv::Mat(400, 600, CV_8UC3);
+	int speed = 4, offset = 0, redraws = 0;
+	bool dirty = true, running = true;
+
+	for (int x = 0; x < gradient.cols; x++) {
+		cv::line(gradient, cv::Point(x, 0), cv::Point(x, gradient.rows), cv::Scalar(x * 255 / gradient.cols, 80, 255 - x * 255 / gradient.cols));
+	}
+
+	cvui::cvui_context_t *window = cvui::init(WINDOW_NAME, 20);
+
+	while (running) {
+		// A fake video: the gradient scrolls horizontally.
+		offset = (offset + speed) % frame.cols;
+		gradient.colRange(offset, frame.cols).copyTo(frame.colRange(0, frame.cols - offset));
+		gradient.colRange(0, offset).copyTo(frame.colRange(frame.cols - offset, frame.cols));
+
+		// The UI is only rendered when it changes, e.g. the mouse moved over it.
+		if (dirty) {
+			cv::Mat& ui = cvui::layer(frame.size(), window);
+			redraws++;
+
+			cvui::window(ui, 10, 10, 200, 120, "Video");
+			cvui::text(ui, 20, 40, "Speed");
+			cvui::counter(ui, 20, 60, &speed);
+			speed = std::max(0, std::min(speed, 50));
+			cvui::printf(ui, 20, 95, 0.4, 0xCECECE, "UI rendered %d times", redraws);
+
+			if (cvui::button(ui, ui.cols - 80, ui.rows - 40, "&Quit")) {
+				running = false;
+			}
+		}
+
+		// Blend the UI over the frame and show it.
+		dirty = cvui::imshow(window, frame);
+	}
+
+	return 0;
+}
@@ -0,0 +1,104 @@
+/*
+Checks that windows can be watched again, e.g. after being closed and reopened.
+
+Watching a window that cvui already knows resets its context. The test renders
+many components and annotations (whose labels change every frame, like the scores
+of a detector) into a window, watches it again, and repeats, checking after every
+frame that the widget stores of the window count exactly the entries they hold.
+A store whose count falls behind its entries eventually has no empty slot left,
+and looking up a new widget then never ends, which ctest reports as a timeout.
+
+Usage: cvui_test_contexts [--rounds <amount>] [--frames <amount>]
+
+Exit codes: 0 (passed) or 1 (failed).
+
+Code licensed under the MIT license, check LICENSE file.
+*/
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#define CVUI_IMPLEMENTATION
+#include "cvui.h"
+
+// Amount of buttons and annotations rendered in each frame.
+static const int COMPONENTS = 40;
+
+// Amount of entries in use in a widget store.
+size_t usedSlots(const cvui::cvui_widget_store_t& theStore) {
+	size_t aUsed = 0;
+
+	for (const cvui::cvui_widget_t& aSlot : theStore.slots) {
+		aUsed += aSlot.id != 0 ? 1 : 0;
+	}
+
+	return aUsed;
+}
+
+int main(int argc, const char *argv[])
+{
+	int aRounds = 20, aFrames = 30, aFailures = 0;
+	cv::Mat aFrame(300, 400, CV_8UC3);
+	std::vector<cvui::cvui_annotation_t> aAnnotations(COMPONENTS);
+	std::vector<cv::String> aLabels(COMPONENTS);
+	char aLabel[64];
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--rounds") == 0 && i + 1 < argc) {
+			aRounds = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+			aFrames = atoi(argv[++i]);
+		} else {
+			fprintf(stderr, "Usage: %s [--rounds <amount>] [--frames <amount>]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	cvui::errorPolicy(cvui::ERROR_RECOVER);
+
+	for (int aRound = 0; aRound < aRounds; aRound++) {
+		// Same name every round, i.e. the window is watched again.
+		cvui::cvui_context_t *aContext = cvui::offscreen("window");
+		cvui::context(aContext);
+
+		for (int aFrameIndex = 0; aFrameIndex < aFrames; aFrameIndex++) {
+			aFrame = cv::Scalar(49, 52, 49);
+
+			for (int i = 0; i < COMPONENTS; i++) {
+				// Labels and explicit ids never repeat, so every frame adds new entries.
+				snprintf(aLabel, sizeof(aLabel), "object %d %.4f", i, (aRound * aFrames + aFrameIndex) / 10000.0);
+				aLabels[i] = aLabel;
+				aAnnotations[i].box = cv::Rect((i % 8) * 48, 20 + (i / 8) * 50, 40, 40);
+				aAnnotations[i].label = aLabels[i].c_str();
+				aAnnotations[i].color = 0x00ff00;
+				aAnnotations[i].fillingColor = 0xff000000;
+
+				cvui::id(aLabels[i]);
+				cvui::button(aFrame, (i % 8) * 48, 280, 40, 16, "B");
+			}
+
+			cvui::annotations(aFrame, aAnnotations.data(), aAnnotations.size());
+			cvui::update(aContext);
+
+			size_t aWidgets = usedSlots(aContext->widgets), aLabelsUsed = usedSlots(aContext->labels);
+
+			if (aWidgets != aContext->widgets.count || aLabelsUsed != aContext->labels.count) {
+				fprintf(stderr, "round %d, frame %d: stores hold %zu widgets and %zu labels, but count %zu and %zu\n", aRound, aFrameIndex, aWidgets, aLabelsUsed, aContext->widgets.count, aContext->labels.count);
+				aFailures++;
+			}
+		}
+	}
+
+	if (cvui::errors() != 0) {
+		fprintf(stderr, "cvui found %u errors\n", cvui::errors());
+		aFailures++;
+	}
+
+	printf("%d rounds of %d frames, %d failures\n", aRounds, aFrames, aFailures);
+	return aFailures == 0 ? 0 : 1;
+}
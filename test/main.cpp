@@ -0,0 +1,483 @@
+/*
+Golden-image regression tests of cvui.
+
+Each scenario reproduces a scene of the examples (see example/src) headlessly,
+i.e. into an offscreen context (see cvui::offscreen()), and compares the result
+with a golden image stored in test/golden. Pixels may differ by a small tolerance,
+so tiny changes in anti-aliasing do not break the tests. Each scenario is also
+rendered several times, interleaved with a calibration frame that only uses
+OpenCV. The median frame time of the scenario, divided by the one of the
+calibration frame, must be at most 1.5 times the baseline ratio of the scenario
+in test/budgets.txt, so budgets do not depend on the speed of the machine. The
+calibration frame only runs (prebuilt) OpenCV code, so ratios depend on how the
+test itself was compiled: budgets are only checked in Release builds, which is
+what baselines are recorded from.
+
+Usage: cvui_test --scenario <name> [--golden <dir>] [--budgets <file>] [--build-type=<type>] [--tolerance <value>] [--update]
+
+Exit codes: 0 (passed) or 1 (failed, including a missing golden image, or a
+missing baseline in a Release build). Use --update to (re)create the golden
+image of a scenario, and its baseline in a Release build, after an intentional
+change.
+
+Code licensed under the MIT license, check LICENSE file.
+*/
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <opencv2/imgcodecs/imgcodecs.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#define CVUI_IMPLEMENTATION
+#include "cvui.h"
+
+// Amount of frames rendered to measure the frame time of a scenario.
+static const int TIMED_FRAMES = 50;
+
+// Most a scenario may take, relative to its baseline ratio, before it fails.
+static const double BUDGET_LIMIT = 1.5;
+
+struct Scenario {
+	const char *name;
+	int width;
+	int height;
+	void (*input)(cvui::cvui_context_t *theContext);
+	void (*render)(cv::Mat& theFrame);
+	int type;    // type of the frame components are rendered into.
+};
+
+void noInput(cvui::cvui_context_t *) {
+}
+
+// Same as example/src/hello-world
+void helloWorld(cv::Mat& theFrame) {
+	cvui::button(theFrame, 110, 80, "Hello, world!");
+	cvui::printf(theFrame, 250, 90, 0.4, 0xff0000, "Button click count: %d", 0);
+}
+
+// The mouse is pressing the third button, so the other ones are idle. There is a
+// single cursor, so the state over is checked by its own scenario (button-over).
+void buttonStatesInput(cvui::cvui_context_t *theContext) {
+	cvui::injectMouse(theContext, cvui::EVENT_MOUSEMOVE, 250, 60);
+	cvui::injectMouse(theContext, cvui::EVENT_LBUTTONDOWN, 250, 60);
+}
+
+// The mouse is over the second button, without pressing it.
+void buttonOverInput(cvui::cvui_context_t *theContext) {
+	cvui::injectMouse(theContext, cvui::EVENT_MOUSEMOVE, 150, 60);
+}
+
+void buttonStates(cv::Mat& theFrame) {
+	cvui::button(theFrame, 10, 50, 100, 30, "Idle");
+	cvui::button(theFrame, 120, 50, 100, 30, "Over");
+	cvui::button(theFrame, 230, 50, 100, 30, "Down");
+	cvui::button(theFrame, 10, 100, "&Shortcut");
+}
+
+// Same as the first rows of example/src/row-column, with generated images.
+void rowColumn(cv::Mat& theFrame) {
+	static std::vector<double> aValues = { 3, 8, 2, 9, 4, 7, 1, 6, 5, 8, 2, 9, 3, 7, 4, 6, 5, 8, 1, 9 };
+	static cv::Mat aImage(40, 40, CV_8UC3, cv::Scalar(40, 120, 200));
+	static cv::Mat aImageGray(40, 40, CV_8UC3, cv::Scalar(128, 128, 128));
+	static cv::Mat aImageRed(40, 40, CV_8UC3, cv::Scalar(0, 0, 200));
+	static bool aChecked = false;
+	static double aValue = 1.0, aValue2 = 1.0, aValue3 = 1.0;
+
+	cvui::beginRow(theFrame, 10, 20, 100, 50);
+		cvui::text("This is ");
+		cvui::printf("a row");
+		cvui::checkbox("checkbox", &aChecked);
+		cvui::window(80, 80, "window");
+		cvui::rect(50, 50, 0x00ff00, 0xff0000);
+		cvui::sparkline(aValues, 50, 50);
+		cvui::counter(&aValue);
+		cvui::button(100, 30, "Fixed");
+		cvui::image(aImage);
+		cvui::button(aImage, aImageGray, aImageRed);
+	cvui::endRow();
+
+	cvui::beginRow(theFrame, 10, 250, 100, 50);
+		cvui::text("This is ");
+		cvui::printf("another row with a trackbar ");
+		cvui::trackbar(150, &aValue2, 0., 5.);
+		cvui::printf(" and a button ");
+		cvui::button(100, 30, "button");
+	cvui::endRow();
+
+	cvui::beginColumn(theFrame, 300, 330, 100, 200, 10);
+		cvui::text("Column 2 (padding = 10)");
+		cvui::button("button1");
+		cvui::button("button2");
+		cvui::trackbar(150, &aValue3, 0., 5., 1, "%3.2Lf", cvui::TRACKBAR_DISCRETE, 0.25);
+		cvui::text("End of column 2");
+	cvui::endColumn();
+}
+
+// Same as the first row of example/src/nested-rows-columns
+void nestedRowsColumns(cv::Mat& theFrame) {
+	cvui::beginRow(theFrame, 10, 50, 100, 150);
+		cvui::text("Row starts");
+		cvui::button("here");
+		cvui::beginColumn(100, 150);
+			cvui::text("Column 1");
+			cvui::button("button1");
+			cvui::button("button2");
+			cvui::button("button3");
+			cvui::text("End of column 1");
+		cvui::endColumn();
+		cvui::text("Hi again,");
+		cvui::text("its me!");
+		cvui::beginColumn(100, 50);
+			cvui::text("Column 2");
+			cvui::button("button1");
+			cvui::button("button2");
+			cvui::button("button3");
+			cvui::space();
+			cvui::text("Another text");
+			cvui::space(40);
+			cvui::text("End of column 2");
+		cvui::endColumn();
+		cvui::text("this is the ");
+		cvui::text("end of the row!");
+	cvui::endRow();
+}
+
+// Same as the first trackbars of example/src/trackbar
+void trackbars(cv::Mat& theFrame) {
+	static double aDouble = 45., aDouble2 = 15., aDouble3 = 10.3;
+	static float aFloat = 12.;
+	static uchar aUchar = 30;
+	static int aInt = 30;
+
+	cvui::text(theFrame, 10, 10, "double, step 1.0 (default)");
+	cvui::trackbar(theFrame, 10, 40, 300, &aDouble, (double)0., (double)100.);
+	cvui::text(theFrame, 10, 120, "float, step 1.0 (default)");
+	cvui::trackbar(theFrame, 10, 150, 300, &aFloat, (float)10., (float)15.);
+	cvui::text(theFrame, 10, 230, "double, 4 segments, custom label %.2Lf");
+	cvui::trackbar(theFrame, 10, 260, 300, &aDouble2, (double)0., (double)20., 4, "%.2Lf");
+	cvui::text(theFrame, 10, 340, "uchar, custom label %.0Lf");
+	cvui::trackbar(theFrame, 10, 370, 300, &aUchar, (uchar)0, (uchar)255, 0, "%.0Lf");
+	cvui::text(theFrame, 10, 450, "double, step 0.1, option TRACKBAR_DISCRETE");
+	cvui::trackbar(theFrame, 10, 480, 300, &aDouble3, (double)10., (double)10.5, 1, "%.1Lf", cvui::TRACKBAR_DISCRETE, (double)0.1);
+	cvui::text(theFrame, 10, 560, "int, 3 segments, DISCRETE | HIDE_SEGMENT_LABELS");
+	cvui::trackbar(theFrame, 10, 590, 300, &aInt, (int)10, (int)50, 3, "%.0Lf", cvui::TRACKBAR_DISCRETE | cvui::TRACKBAR_HIDE_SEGMENT_LABELS, (int)2);
+}
+
+// Similar to example/src/sparkline, with generated values.
+void sparklines(cv::Mat& theFrame) {
+	static std::vector<double> aWave, aSingle = { 1.0 }, aEmpty;
+
+	if (aWave.empty()) {
+		for (int i = 0; i < 500; i++) {
+			aWave.push_back(std::sin(i * 0.05) * 50.0 + std::sin(i * 0.3) * 10.0);
+		}
+	}
+
+	cvui::sparkline(theFrame, aWave, 10, 10, 580, 100);
+	cvui::sparkline(theFrame, aWave, 10, 120, 280, 50, 0xff0000);
+	cvui::sparkline(theFrame, aSingle, 300, 120, 100, 50);
+	cvui::sparkline(theFrame, aEmpty, 410, 120, 100, 50);
+}
+
+void tableCell(int theRow, int theColumn, char *theBuffer, size_t theBufferSize, void *) {
+	switch (theColumn) {
+		case 0: snprintf(theBuffer, theBufferSize, "%d", theRow); break;
+		case 1: snprintf(theBuffer, theBufferSize, "class %d", (theRow * 7) % 80); break;
+		case 2: snprintf(theBuffer, theBufferSize, "%.3f", ((theRow * 37) % 1000) / 1000.0); break;
+		case 3: snprintf(theBuffer, theBufferSize, "%s", theRow % 2 ? "yes" : "no"); break;
+	}
+}
+
+// Similar to example/src/table, with generated rows.
+void table(cv::Mat& theFrame) {
+	static cvui::cvui_table_t aTable;
+	static const cv::String aHeaders[] = { "Id", "Label", "Score", "Valid" };
+	static const int aWidths[] = { 60, 90, 70, 60 };
+
+	cvui::table(theFrame, 10, 10, 300, 250, &aTable, 1000, 4, aHeaders, aWidths, tableCell);
+}
+
+// Window, translucent rects, counters and checkboxes, like example/src/complext-layout.
+void windowRect(cv::Mat& theFrame) {
+	static int aCount = 2;
+	static double aCountDouble = 3.5;
+	static bool aChecked = true, aUnchecked = false;
+
+	cvui::window(theFrame, 10, 10, 250, 180, "Settings");
+	cvui::checkbox(theFrame, 20, 40, "Checked", &aChecked);
+	cvui::checkbox(theFrame, 20, 65, "Unchecked", &aUnchecked);
+	cvui::counter(theFrame, 20, 95, &aCount);
+	cvui::counter(theFrame, 20, 125, &aCountDouble, 0.5, "%.1f");
+	cvui::rect(theFrame, 280, 20, 100, 80, 0xff0000, 0x80ff0000);
+	cvui::rect(theFrame, 320, 60, 100, 80, 0x00ff00, 0x4000ff00);
+	cvui::rect(theFrame, 280, 150, 140, 30, 0xffffff);
+}
+
+// Components rendered into frames other than CV_8UC3, e.g. depth images.
+void frameTypes(cv::Mat& theFrame) {
+	static cv::Mat aImage(40, 40, CV_8UC3, cv::Scalar(40, 120, 200));
+	static bool aChecked = true;
+	static double aValue = 2.5;
+
+	cvui::window(theFrame, 10, 10, 200, 150, "Depth");
+	cvui::button(theFrame, 20, 40, "Button");
+	cvui::checkbox(theFrame, 20, 80, "Checkbox", &aChecked);
+	cvui::trackbar(theFrame, 220, 20, 150, &aValue, 0., 5.);
+	cvui::image(theFrame, 20, 110, aImage);
+	cvui::rect(theFrame, 230, 100, 100, 50, 0x00ff00, 0x80ff0000);
+}
+
+// Components rendered into the UI layer, which is then blended over a frame with some content.
+void layerComposite(cv::Mat& theFrame) {
+	static int aCount = 7;
+
+	for (int x = 0; x < theFrame.cols; x += 40) {
+		cv::rectangle(theFrame, cv::Rect(x, 0, 20, theFrame.rows), cv::Scalar(200, 120, 40), cv::FILLED);
+	}
+
+	cv::Mat& aLayer = cvui::layer(theFrame.size());
+	cvui::window(aLayer, 10, 10, 200, 150, "Layer");
+	cvui::button(aLayer, 20, 40, "Button");
+	cvui::counter(aLayer, 20, 80, &aCount);
+	cvui::rect(aLayer, 230, 20, 100, 80, 0xff0000, 0x80ff0000);
+	cvui::rect(aLayer, 270, 60, 100, 80, 0x00ff00, 0x4000ff00);
+	cvui::composite(theFrame);
+}
+
+static const Scenario gScenarios[] = {
+	{ "hello-world", 500, 200, noInput, helloWorld, CV_8UC3 },
+	{ "button-states", 350, 150, buttonStatesInput, buttonStates, CV_8UC3 },
+	{ "button-over", 350, 150, buttonOverInput, buttonStates, CV_8UC3 },
+	{ "row-column", 800, 600, noInput, rowColumn, CV_8UC3 },
+	{ "nested-rows-columns", 800, 250, noInput, nestedRowsColumns, CV_8UC3 },
+	{ "trackbar", 350, 650, noInput, trackbars, CV_8UC3 },
+	{ "sparkline", 600, 180, noInput, sparklines, CV_8UC3 },
+	{ "table", 320, 270, noInput, table, CV_8UC3 },
+	{ "window-rect", 440, 200, noInput, windowRect, CV_8UC3 },
+	{ "frame-8uc1", 400, 170, noInput, frameTypes, CV_8UC1 },
+	{ "frame-8uc4", 400, 170, noInput, frameTypes, CV_8UC4 },
+	{ "frame-16uc1", 400, 170, noInput, frameTypes, CV_16UC1 },
+	{ "frame-16uc3", 400, 170, noInput, frameTypes, CV_16UC3 },
+	{ "layer-composite", 400, 170, noInput, layerComposite, CV_8UC3 },
+};
+
+// Rendered in the same process as each scenario, so frame times are compared with
+// the time of this frame instead of in milliseconds, which depend on the machine.
+// It only uses OpenCV, so a slower cvui changes the ratio of the scenarios.
+void calibration(cv::Mat& theFrame) {
+	for (int i = 0; i < 20; i++) {
+		cv::rectangle(theFrame, cv::Rect(10 + i * 5, 10 + i * 5, 100, 30), cv::Scalar(66, 66, 66), cv::FILLED);
+		cv::putText(theFrame, "Calibration", cv::Point(20 + i * 5, 30 + i * 5), cv::FONT_HERSHEY_SIMPLEX, 0.4, cv::Scalar(206, 206, 206), 1, cv::LINE_AA);
+	}
+}
+
+double baselineOf(const std::string& theFile, const std::string& theScenario) {
+	std::ifstream aFile(theFile.c_str());
+	std::string aLine, aName;
+	double aBaseline;
+
+	// Each line is "<scenario> <baseline ratio>". Lines starting with # are comments.
+	while (std::getline(aFile, aLine)) {
+		std::istringstream aStream(aLine);
+
+		if (aLine.empty() || aLine[0] == '#' || !(aStream >> aName >> aBaseline)) {
+			continue;
+		}
+
+		if (aName == theScenario) {
+			return aBaseline;
+		}
+	}
+
+	return -1;
+}
+
+bool saveBaseline(const std::string& theFile, const std::string& theScenario, double theBaseline) {
+	std::ifstream aInput(theFile.c_str());
+	std::vector<std::string> aLines;
+	std::string aLine, aName;
+	char aEntry[256];
+	bool aFound = false;
+
+	snprintf(aEntry, sizeof(aEntry), "%s %.3f", theScenario.c_str(), theBaseline);
+
+	while (std::getline(aInput, aLine)) {
+		std::istringstream aStream(aLine);
+
+		if (!aLine.empty() && aLine[0] != '#' && (aStream >> aName) && aName == theScenario) {
+			aLine = aEntry;
+			aFound = true;
+		}
+		aLines.push_back(aLine);
+	}
+
+	if (!aFound) {
+		aLines.push_back(aEntry);
+	}
+
+	aInput.close();
+	std::ofstream aOutput(theFile.c_str());
+
+	for (const std::string& aEntryLine : aLines) {
+		aOutput << aEntryLine << "\n";
+	}
+
+	return aOutput.good();
+}
+
+int main(int argc, const char *argv[])
+{
+	std::string aScenarioName, aGoldenDir = "golden", aBudgetsFile = "budgets.txt";
+	const Scenario *aScenario = nullptr;
+	std::string aBuildType;
+	bool aUpdate = false;
+	int aTolerance = 2;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--scenario") == 0 && i + 1 < argc) {
+			aScenarioName = argv[++i];
+		} else if (strcmp(argv[i], "--golden") == 0 && i + 1 < argc) {
+			aGoldenDir = argv[++i];
+		} else if (strcmp(argv[i], "--budgets") == 0 && i + 1 < argc) {
+			aBudgetsFile = argv[++i];
+		} else if (strncmp(argv[i], "--build-type=", 13) == 0) {
+			aBuildType = argv[i] + 13;
+		} else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+			aTolerance = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--update") == 0) {
+			aUpdate = true;
+		} else {
+			fprintf(stderr, "Usage: %s --scenario <name> [--golden <dir>] [--budgets <file>] [--build-type=<type>] [--tolerance <value>] [--update]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	for (const Scenario& aEntry : gScenarios) {
+		if (aScenarioName == aEntry.name) {
+			aScenario = &aEntry;
+		}
+	}
+
+	if (aScenario == nullptr) {
+		fprintf(stderr, "Unknown scenario \"%s\". Available scenarios:", aScenarioName.c_str());
+		for (const Scenario& aEntry : gScenarios) {
+			fprintf(stderr, " %s", aEntry.name);
+		}
+		fprintf(stderr, "\n");
+		return 1;
+	}
+
+	cv::Mat aFrame(aScenario->height, aScenario->width, aScenario->type);
+	cv::Mat aCalibrationFrame(aScenario->height, aScenario->width, CV_8UC3);
+	cvui::cvui_context_t *aContext = cvui::offscreen(aScenario->name);
+	std::string aGolden = aGoldenDir + "/" + aScenario->name + ".png";
+	std::vector<double> aTimes, aCalibrationTimes;
+	int aResult = 0;
+
+	cvui::context(aContext);
+	aScenario->input(aContext);
+
+	// The background has the same color in every type of frame.
+	cv::Scalar aBackground = cvui::internal::targetColor(aFrame, cv::Scalar(49, 52, 49));
+
+	// The first frame is the one compared with the golden image.
+	aFrame = aBackground;
+	aScenario->render(aFrame);
+	cvui::update(aContext);
+	cv::Mat aRendered = aFrame.clone();
+
+	// Frames of the scenario and of the calibration are interleaved, so both are
+	// equally affected by whatever else the machine is doing.
+	for (int i = 0; i < TIMED_FRAMES; i++) {
+		auto aStart = std::chrono::steady_clock::now();
+		aCalibrationFrame = cv::Scalar(49, 52, 49);
+		calibration(aCalibrationFrame);
+		aCalibrationTimes.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - aStart).count());
+
+		aStart = std::chrono::steady_clock::now();
+		aFrame = aBackground;
+		aScenario->render(aFrame);
+		cvui::update(aContext);
+		aTimes.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - aStart).count());
+	}
+
+	std::sort(aTimes.begin(), aTimes.end());
+	std::sort(aCalibrationTimes.begin(), aCalibrationTimes.end());
+	double aMedian = aTimes[aTimes.size() / 2];
+	double aRatio = aMedian / std::max(aCalibrationTimes[aCalibrationTimes.size() / 2], 1e-6);
+	double aBaseline = baselineOf(aBudgetsFile, aScenario->name);
+	bool aBudgeted = aBuildType == "Release";
+
+	printf("%s: median frame time %.3f ms, %.3f times the calibration frame", aScenario->name, aMedian, aRatio);
+	if (!aBudgeted) {
+		printf(" (budget not checked in %s builds)", aBuildType.empty() ? "unknown" : aBuildType.c_str());
+	} else if (aBaseline > 0) {
+		printf(" (baseline %.3f, limit %.3f)", aBaseline, aBaseline * BUDGET_LIMIT);
+	}
+	printf("\n");
+
+	if (aUpdate) {
+		if (!cv::imwrite(aGolden, aRendered)) {
+			fprintf(stderr, "%s: unable to write %s\n", aScenario->name, aGolden.c_str());
+			return 1;
+		}
+		if (aBudgeted && !saveBaseline(aBudgetsFile, aScenario->name, aRatio)) {
+			fprintf(stderr, "%s: unable to write %s\n", aScenario->name, aBudgetsFile.c_str());
+			return 1;
+		}
+		printf("%s: golden image%s updated\n", aScenario->name, aBudgeted ? " and baseline" : "");
+		return 0;
+	}
+
+	if (aBudgeted && aBaseline <= 0) {
+		fprintf(stderr, "%s: no baseline in %s (use --update to record it)\n", aScenario->name, aBudgetsFile.c_str());
+		aResult = 1;
+	} else if (aBudgeted && aRatio > aBaseline * BUDGET_LIMIT) {
+		fprintf(stderr, "%s: frame time over budget\n", aScenario->name);
+		aResult = 1;
+	}
+
+	// Golden images keep the type of the frame, e.g. 16 bits per channel.
+	cv::Mat aExpected = cv::imread(aGolden, cv::IMREAD_UNCHANGED);
+
+	if (aExpected.empty()) {
+		fprintf(stderr, "%s: no golden image at %s (use --update to create it)\n", aScenario->name, aGolden.c_str());
+		return 1;
+	}
+
+	if (aExpected.size() != aRendered.size() || aExpected.type() != aRendered.type()) {
+		fprintf(stderr, "%s: golden image is %dx%d (type %d), rendered frame is %dx%d (type %d)\n", aScenario->name, aExpected.cols, aExpected.rows, aExpected.type(), aRendered.cols, aRendered.rows, aRendered.type());
+		return 1;
+	}
+
+	// Colors of 16-bit frames are scaled by 257, and so is the tolerance.
+	if (aRendered.depth() == CV_16U) {
+		aTolerance *= 257;
+	}
+
+	// A pixel differs if any of its channels differs by more than the tolerance.
+	cv::Mat aDiff, aMask;
+	cv::absdiff(aExpected, aRendered, aDiff);
+	aDiff = aDiff.reshape(1, aDiff.rows * aDiff.cols);
+	cv::reduce(aDiff, aMask, 1, cv::REDUCE_MAX);
+	int aDiffering = cv::countNonZero(aMask > aTolerance);
+
+	if (aDiffering > 0) {
+		std::string aActual = std::string(aScenario->name) + ".actual.png";
+		cv::imwrite(aActual, aRendered);
+		fprintf(stderr, "%s: %d pixels differ from the golden image by more than %d (rendered frame saved as %s)\n", aScenario->name, aDiffering, aTolerance, aActual.c_str());
+		aResult = 1;
+	}
+
+	return aResult;
+}
@@ -0,0 +1,146 @@
+/*
+Checks that the rendering primitives of cvui produce exactly the same pixels as OpenCV.
+
+cvui::internal::line() and cvui::internal::rectangle() write horizontal and vertical
+spans directly into the frame instead of calling cv::line() and cv::rectangle(). This
+test renders the same shapes both ways, in frames of every type cvui supports, and
+compares them bit by bit. Shapes include random ones, shapes partially or completely
+outside the frame, rects with negative sizes and shapes one pixel wide.
+
+Usage: cvui_test_primitives [--seed <value>] [--shapes <amount>]
+
+Exit codes: 0 (passed) or 1 (failed).
+
+Code licensed under the MIT license, check LICENSE file.
+*/
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#define CVUI_IMPLEMENTATION
+#include "cvui.h"
+
+static const int FRAME_WIDTH = 64;
+static const int FRAME_HEIGHT = 48;
+
+struct FrameType {
+	const char *name;
+	int type;
+};
+
+// Rects that are easy to get wrong, besides the random ones.
+static const cv::Rect gEdgeRects[] = {
+	cv::Rect(10, 10, 1, 1),                      // single pixel.
+	cv::Rect(10, 10, 1, 20),                     // one pixel wide.
+	cv::Rect(10, 10, 20, 1),                     // one pixel tall.
+	cv::Rect(10, 10, 0, 5),                      // empty.
+	cv::Rect(10, 10, 5, 0),
+	cv::Rect(30, 20, -10, -8),                   // negative size.
+	cv::Rect(30, 20, -10, 8),                    // negative width only, i.e. negative area.
+	cv::Rect(-5, -5, 20, 20),                    // clipped at the top-left corner.
+	cv::Rect(FRAME_WIDTH - 10, FRAME_HEIGHT - 10, 30, 30), // clipped at the bottom-right corner.
+	cv::Rect(-10, -10, FRAME_WIDTH + 20, FRAME_HEIGHT + 20), // larger than the frame.
+	cv::Rect(FRAME_WIDTH + 5, 5, 10, 10),        // completely outside.
+	cv::Rect(0, 0, FRAME_WIDTH, FRAME_HEIGHT),   // exactly the frame.
+	cv::Rect(FRAME_WIDTH - 1, FRAME_HEIGHT - 1, 1, 1), // last pixel.
+};
+
+cv::Scalar randomColor(cv::RNG& theRNG) {
+	return cv::Scalar(theRNG.uniform(0, 256), theRNG.uniform(0, 256), theRNG.uniform(0, 256), theRNG.uniform(0, 256));
+}
+
+cv::Rect randomRect(cv::RNG& theRNG) {
+	return cv::Rect(theRNG.uniform(-20, FRAME_WIDTH + 20), theRNG.uniform(-20, FRAME_HEIGHT + 20), theRNG.uniform(-30, 40), theRNG.uniform(-30, 40));
+}
+
+cv::Point randomPoint(cv::RNG& theRNG) {
+	return cv::Point(theRNG.uniform(-20, FRAME_WIDTH + 20), theRNG.uniform(-20, FRAME_HEIGHT + 20));
+}
+
+// Renders a shape with cvui and with OpenCV, in frames with the same random content, and compares them.
+template<typename Render, typename Reference>
+bool compare(const FrameType& theType, const char *theShape, cv::RNG& theRNG, Render theRender, Reference theReference) {
+	cv::Mat aBackground(FRAME_HEIGHT, FRAME_WIDTH, theType.type);
+	theRNG.fill(aBackground, cv::RNG::UNIFORM, 0, aBackground.depth() == CV_16U ? 65536 : 256);
+
+	cv::Mat aActual = aBackground.clone(), aExpected = aBackground.clone();
+	theRender(aActual);
+	theReference(aExpected);
+
+	if (cv::norm(aActual, aExpected, cv::NORM_INF) != 0) {
+		fprintf(stderr, "%s: %s differs from OpenCV\n", theType.name, theShape);
+		return false;
+	}
+
+	return true;
+}
+
+int main(int argc, const char *argv[])
+{
+	const FrameType aTypes[] = {
+		{ "CV_8UC1", CV_8UC1 }, { "CV_8UC3", CV_8UC3 }, { "CV_8UC4", CV_8UC4 },
+		{ "CV_16UC1", CV_16UC1 }, { "CV_16UC3", CV_16UC3 }, { "CV_16UC4", CV_16UC4 },
+	};
+	unsigned int aSeed = 0xC0FFEE;
+	int aShapes = 500, aFailures = 0, aChecks = 0;
+	char aShape[128];
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+			aSeed = (unsigned int)strtoul(argv[++i], nullptr, 0);
+		} else if (strcmp(argv[i], "--shapes") == 0 && i + 1 < argc) {
+			aShapes = atoi(argv[++i]);
+		} else {
+			fprintf(stderr, "Usage: %s [--seed <value>] [--shapes <amount>]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	cv::RNG aRNG(aSeed);
+
+	for (const FrameType& aType : aTypes) {
+		std::vector<cv::Rect> aRects(gEdgeRects, gEdgeRects + sizeof(gEdgeRects) / sizeof(gEdgeRects[0]));
+
+		for (int i = 0; i < aShapes; i++) {
+			aRects.push_back(randomRect(aRNG));
+		}
+
+		for (const cv::Rect& aRect : aRects) {
+			cv::Scalar aColor = randomColor(aRNG);
+
+			for (int aThickness : { 1, CVUI_FILLED }) {
+				snprintf(aShape, sizeof(aShape), "rectangle(%d, %d, %d, %d, thickness %d)", aRect.x, aRect.y, aRect.width, aRect.height, aThickness);
+				aFailures += compare(aType, aShape, aRNG,
+					[&](cv::Mat& theWhere) { cvui::internal::rectangle(theWhere, aRect, aColor, aThickness); },
+					[&](cv::Mat& theWhere) { cv::rectangle(theWhere, aRect, cvui::internal::targetColor(theWhere, aColor), aThickness); }) ? 0 : 1;
+				aChecks++;
+			}
+		}
+
+		// Horizontal, vertical and single point lines take the fast path, the others go to OpenCV.
+		for (int i = 0; i < aShapes; i++) {
+			cv::Point aFrom = randomPoint(aRNG), aTo = randomPoint(aRNG);
+			cv::Scalar aColor = randomColor(aRNG);
+
+			switch (i % 4) {
+				case 0: aTo.y = aFrom.y; break;
+				case 1: aTo.x = aFrom.x; break;
+				case 2: aTo = aFrom; break;
+			}
+
+			snprintf(aShape, sizeof(aShape), "line(%d, %d, %d, %d)", aFrom.x, aFrom.y, aTo.x, aTo.y);
+			aFailures += compare(aType, aShape, aRNG,
+				[&](cv::Mat& theWhere) { cvui::internal::line(theWhere, aFrom, aTo, aColor); },
+				[&](cv::Mat& theWhere) { cv::line(theWhere, aFrom, aTo, cvui::internal::targetColor(theWhere, aColor)); }) ? 0 : 1;
+			aChecks++;
+		}
+	}
+
+	printf("%d of %d shapes match OpenCV\n", aChecks - aFailures, aChecks);
+	return aFailures == 0 ? 0 : 1;
+}
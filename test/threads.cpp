@@ -0,0 +1,160 @@
+/*
+Stress test of cvui with the UI of several windows built by several threads.
+
+Each thread drives an offscreen window of its own (see cvui::offscreen()): it
+injects clicks into the window, renders components into its frame and calls
+cvui::update(), while another thread keeps creating and looking up other
+windows by name. Every thread checks that all of its clicks were received,
+that the ids of its components are stable and that cvui found no errors.
+
+Build it with the CMake option CVUI_TSAN to run it under ThreadSanitizer,
+which reports any data race found while the threads run.
+
+Usage: cvui_test_threads [--windows <amount>] [--frames <amount>]
+
+Exit codes: 0 (passed) or 1 (failed).
+
+Code licensed under the MIT license, check LICENSE file.
+*/
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define CVUI_IMPLEMENTATION
+#include "cvui.h"
+
+// Frames between the clicks injected by each thread.
+static const int CLICK_PERIOD = 4;
+
+// Frames rendered after the last click, so every queued event is applied.
+static const int SETTLE_FRAMES = 8;
+
+struct Window {
+	cv::String name;
+	cvui::cvui_context_t *handle;
+	int clicks;               // clicks received by the button.
+	unsigned int errors;      // errors cvui found in all frames.
+	bool stableIds;           // if the button had the same id in every frame.
+};
+
+void worker(Window *theWindow, int theFrames) {
+	cv::Mat aFrame(200, 300, CV_8UC3);
+	std::vector<double> aValues(50);
+	double aValue = 0.5;
+	bool aChecked = false;
+	unsigned int aButtonId = 0;
+
+	for (size_t i = 0; i < aValues.size(); i++) {
+		aValues[i] = (double)((i * 7) % 13);
+	}
+
+	cvui::context(theWindow->handle);
+
+	for (int i = 0; i < theFrames + SETTLE_FRAMES; i++) {
+		// Offscreen windows receive input from the thread rendering them.
+		if (i < theFrames && i % CLICK_PERIOD == 0) {
+			cvui::injectMouse(theWindow->handle, cvui::EVENT_MOUSEMOVE, 50, 25);
+			cvui::injectMouse(theWindow->handle, cvui::EVENT_LBUTTONDOWN, 50, 25);
+		} else if (i < theFrames && i % CLICK_PERIOD == CLICK_PERIOD / 2) {
+			cvui::injectMouse(theWindow->handle, cvui::EVENT_LBUTTONUP, 50, 25);
+		}
+
+		aFrame = cv::Scalar(49, 52, 49);
+
+		cvui::beginColumn(aFrame, 10, 10, -1, -1, 5);
+			cvui::pushId(theWindow->name.c_str());
+				if (cvui::button(80, 30, "Click")) {
+					theWindow->clicks++;
+				}
+				if (i == 0) {
+					aButtonId = cvui::lastId();
+				} else if (cvui::lastId() != aButtonId) {
+					theWindow->stableIds = false;
+				}
+			cvui::popId();
+			cvui::checkbox("Checkbox", &aChecked);
+			cvui::trackbar(150, &aValue, 0., 1.);
+			cvui::sparkline(aValues, 150, 30);
+			cvui::printf("%s - frame %d", theWindow->name.c_str(), i);
+		cvui::endColumn();
+		cvui::window(aFrame, 180, 10, 100, 80, "Window");
+
+		cvui::update(theWindow->handle);
+		theWindow->errors += cvui::errors(theWindow->handle);
+	}
+}
+
+int main(int argc, const char *argv[])
+{
+	int aWindows = 8, aFrames = 400;
+	std::vector<Window> aWindowsList;
+	std::vector<std::thread> aThreads;
+	std::atomic<bool> aRunning(true);
+	int aResult = 0;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--windows") == 0 && i + 1 < argc) {
+			aWindows = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+			aFrames = atoi(argv[++i]);
+		} else {
+			fprintf(stderr, "Usage: %s [--windows <amount>] [--frames <amount>]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	// Errors are counted instead of terminating the process, so they can be reported.
+	cvui::errorPolicy(cvui::ERROR_RECOVER);
+
+	// Handles are created up front, so the list is not resized while threads use it.
+	aWindowsList.resize(aWindows);
+	for (int i = 0; i < aWindows; i++) {
+		aWindowsList[i].name = "window" + std::to_string(i);
+		aWindowsList[i].handle = cvui::offscreen(aWindowsList[i].name);
+		aWindowsList[i].clicks = 0;
+		aWindowsList[i].errors = 0;
+		aWindowsList[i].stableIds = true;
+	}
+
+	for (int i = 0; i < aWindows; i++) {
+		aThreads.push_back(std::thread(worker, &aWindowsList[i], aFrames));
+	}
+
+	// Meanwhile, windows are created and looked up by name, which changes the list of windows.
+	std::thread aLookups([&aRunning]() {
+		for (int i = 0; aRunning.load(); i = (i + 1) % 64) {
+			cvui::offscreen("lookup" + std::to_string(i));
+			std::this_thread::yield();
+		}
+	});
+
+	for (std::thread& aThread : aThreads) {
+		aThread.join();
+	}
+
+	aRunning.store(false);
+	aLookups.join();
+
+	// A click is complete when its button is released, i.e. in frames i % CLICK_PERIOD == CLICK_PERIOD / 2.
+	int aExpectedClicks = (aFrames + CLICK_PERIOD - 1 - CLICK_PERIOD / 2) / CLICK_PERIOD;
+
+	for (const Window& aWindow : aWindowsList) {
+		bool aPassed = aWindow.clicks == aExpectedClicks && aWindow.errors == 0 && aWindow.stableIds;
+
+		printf("%s: %d of %d clicks, %u errors, %s ids%s\n", aWindow.name.c_str(), aWindow.clicks, aExpectedClicks, aWindow.errors, aWindow.stableIds ? "stable" : "unstable", aPassed ? "" : " (FAILED)");
+
+		if (!aPassed) {
+			aResult = 1;
+		}
+	}
+
+	return aResult;
+}